@@ -0,0 +1,180 @@
+//! End-to-end benchmarks for the IDA Pro backend.
+//!
+//! These use the stand-ins `benches/stub/idat64` and `benches/stub/fugue-batch`
+//! in place of IDA itself and the batch exporter, so they measure only what
+//! the backend adds on top of an export: process launch, temporary directory
+//! handling, argument building, exit-code mapping and handing off the
+//! exported database.
+//!
+//! The stand-ins are configured through the environment:
+//! - `FUGUE_STUB_FDB_SIZE`: size in bytes of each fixture FDB written,
+//! - `FUGUE_STUB_LATENCY_MS`: simulated start-up latency, paid once per launch,
+//! - `FUGUE_STUB_EXIT_CODE`: exit code reported to the backend.
+
+use std::env;
+use std::fs;
+use std::path::{Path, PathBuf};
+use std::process;
+use std::time::Duration;
+
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+
+use fugue_db::backend::{Backend, Imported};
+use fugue_idapro::{Rebase, IDA};
+
+use tempfile::NamedTempFile;
+use url::Url;
+
+fn stub_dir() -> PathBuf {
+    Path::new(env!("CARGO_MANIFEST_DIR")).join("benches").join("stub")
+}
+
+fn configure_stub(size: usize, latency_ms: u64) {
+    env::set_var("FUGUE_STUB_FDB_SIZE", size.to_string());
+    env::set_var("FUGUE_STUB_LATENCY_MS", latency_ms.to_string());
+    env::remove_var("FUGUE_STUB_EXIT_CODE");
+}
+
+fn input() -> (NamedTempFile, Url) {
+    let file = NamedTempFile::new().expect("input file");
+    let url = Url::from_file_path(file.path()).expect("input url");
+    (file, url)
+}
+
+// NOTE: the backend leaves the export to the consumer; remove it (and its
+// directory, once empty) so repeated iterations do not measure disk growth
+fn hand_off(imported: Imported) -> usize {
+    match imported {
+        Imported::File(path) => {
+            let size = fs::metadata(&path).map(|m| m.len() as usize).unwrap_or(0);
+            let _ = fs::remove_file(&path);
+            if let Some(parent) = path.parent() {
+                let _ = fs::remove_dir(parent);
+            }
+            size
+        }
+        Imported::Bytes(bytes) => bytes.len(),
+    }
+}
+
+fn import_overhead(c: &mut Criterion) {
+    let ida = IDA::from_path(stub_dir()).expect("stand-in idat64");
+    let (_file, program) = input();
+
+    configure_stub(0, 0);
+
+    let mut group = c.benchmark_group("import-overhead");
+
+    // baseline: launching the stand-in directly, without the backend
+    group.bench_function("stub-launch", |b| {
+        let out = tempfile::tempdir().expect("output directory");
+        let output = out.path().join("baseline.fdb");
+        b.iter(|| {
+            process::Command::new(stub_dir().join("idat64"))
+                .arg("-A")
+                .arg(format!("-OFugueOutput:{}", output.display()))
+                .arg(program.path())
+                .output()
+                .expect("stand-in launch")
+        })
+    });
+
+    group.bench_function("backend-import", |b| {
+        b.iter(|| hand_off(ida.import(&program).expect("import")))
+    });
+
+    group.bench_function("backend-import-error", |b| {
+        env::set_var("FUGUE_STUB_EXIT_CODE", "103");
+        b.iter(|| ida.import(&program).is_err());
+        env::remove_var("FUGUE_STUB_EXIT_CODE");
+    });
+
+    group.finish();
+}
+
+fn batch_throughput(c: &mut Criterion) {
+    let ida = IDA::from_path(stub_dir()).expect("stand-in idat64");
+
+    let mut group = c.benchmark_group("batch-throughput");
+    group.measurement_time(Duration::from_secs(10));
+
+    for latency_ms in [0u64, 10] {
+        for batch in [16usize, 64] {
+            configure_stub(64 * 1024, latency_ms);
+
+            let inputs = (0..batch).map(|_| input()).collect::<Vec<_>>();
+
+            let programs = inputs.iter().map(|(_, program)| program.clone()).collect::<Vec<_>>();
+
+            group.throughput(Throughput::Elements(batch as u64));
+
+            // baseline: one launch per program
+            group.bench_with_input(
+                BenchmarkId::new(format!("sequential-latency-{}ms", latency_ms), batch),
+                &programs,
+                |b, programs| {
+                    b.iter(|| {
+                        programs
+                            .iter()
+                            .map(|program| hand_off(ida.import(program).expect("import")))
+                            .sum::<usize>()
+                    })
+                },
+            );
+
+            group.bench_with_input(
+                BenchmarkId::new(format!("batch-latency-{}ms", latency_ms), batch),
+                &programs,
+                |b, programs| {
+                    b.iter(|| {
+                        ida.import_batch(programs)
+                            .expect("batch")
+                            .into_iter()
+                            .map(|imported| hand_off(imported.expect("import")))
+                            .sum::<usize>()
+                    })
+                },
+            );
+        }
+    }
+
+    group.finish();
+}
+
+fn file_hand_off(c: &mut Criterion) {
+    let ida = IDA::from_path(stub_dir()).expect("stand-in idat64");
+    let (_file, program) = input();
+
+    let mut group = c.benchmark_group("file-hand-off");
+
+    for size in [4 * 1024usize, 1024 * 1024, 64 * 1024 * 1024] {
+        configure_stub(size, 0);
+
+        group.throughput(Throughput::Bytes(size as u64));
+        group.bench_with_input(BenchmarkId::new("import", size), &size, |b, _| {
+            b.iter(|| hand_off(ida.import(&program).expect("import")))
+        });
+    }
+
+    configure_stub(1024 * 1024, 0);
+
+    let rebases = (0..4)
+        .map(|i| Rebase::Relative(i * 0x10000))
+        .collect::<Vec<_>>();
+
+    group.throughput(Throughput::Elements(rebases.len() as u64));
+    group.bench_function("import-rebased", |b| {
+        b.iter(|| {
+            ida.import_rebased(&program, &rebases)
+                .expect("import")
+                .into_iter()
+                .map(hand_off)
+                .sum::<usize>()
+        })
+    });
+
+    group.finish();
+}
+
+criterion_group!(benches, import_overhead, batch_throughput, file_hand_off);
+criterion_main!(benches);
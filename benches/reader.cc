@@ -0,0 +1,171 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include <fugue_reader.h>
+
+// Compares opening an FDB with full-buffer verification against the reader's
+// lazy verification, for a workload of random point queries. After a full
+// verification, the reader skips its per-table checks, so each mode pays
+// only for its own verification.
+//
+// Usage: fugue-reader-bench <fdb> [<queries>]
+//
+// Each mode maps the FDB afresh and reports its wall time and the page faults
+// taken; the file should be in the page cache (e.g., run twice) so that the
+// results reflect the pages touched rather than disk throughput.
+
+namespace fugue
+{
+  namespace bench
+  {
+    struct Sample
+    {
+      std::chrono::steady_clock::time_point time;
+      long faults;
+
+      static inline Sample now()
+      {
+#ifndef _WIN32
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return Sample{std::chrono::steady_clock::now(), usage.ru_minflt + usage.ru_majflt};
+#else
+        return Sample{std::chrono::steady_clock::now(), 0};
+#endif
+      }
+    };
+
+    inline void report(const char *mode, const char *phase, Sample const &from, Sample const &to)
+    {
+      std::printf(
+          "%-6s %-14s %12.3f ms %12ld faults\n",
+          mode,
+          phase,
+          std::chrono::duration<double, std::milli>(to.time - from.time).count(),
+          to.faults - from.faults);
+    }
+
+    // resolves `queries` random function addresses to blocks, walks their
+    // successors, and looks their functions up by name; returns a checksum so
+    // that the work cannot be elided
+    inline uint64_t run_queries(FdbReader const &reader, size_t queries, const char *mode)
+    {
+      auto checksum = uint64_t(0);
+      auto count = reader.function_count();
+      if (count == 0)
+      {
+        return checksum;
+      }
+
+      auto random = std::mt19937_64(0x66756775);
+      auto pick = std::uniform_int_distribution<size_t>(0, count - 1);
+
+      auto start = Sample::now();
+      for (size_t i = 0; i != queries; ++i)
+      {
+        auto fn = reader.function(pick(random));
+        if (fn == nullptr)
+        {
+          continue;
+        }
+
+        if (auto ref = reader.block_at(fn->address()); ref.has_value())
+        {
+          checksum += ref->value();
+          if (auto block = reader.block(*ref))
+          {
+            for (auto succ : reader.successors(block))
+              checksum += succ.value();
+          }
+        }
+      }
+      report(mode, "address", start, Sample::now());
+
+      start = Sample::now();
+      for (size_t i = 0; i != queries; ++i)
+      {
+        auto fn = reader.function(pick(random));
+        if (fn == nullptr || fn->symbol() == nullptr)
+        {
+          continue;
+        }
+
+        auto name = std::string_view(fn->symbol()->c_str(), fn->symbol()->size());
+        if (auto found = reader.function_by_name(name); found.has_value())
+        {
+          checksum += *found;
+        }
+      }
+      report(mode, "name", start, Sample::now());
+
+      return checksum;
+    }
+
+  }; // namespace bench
+};   // namespace fugue
+
+int main(int argc, char *argv[])
+{
+  using namespace fugue;
+  using namespace fugue::bench;
+
+  if (argc < 2 || argc > 3)
+  {
+    std::fprintf(stderr, "usage: fugue-reader-bench <fdb> [<queries>]\n");
+    return 1;
+  }
+
+  auto queries = argc == 3 ? static_cast<size_t>(std::strtoull(argv[2], nullptr, 10)) : size_t(10000);
+  auto checksum = uint64_t(0);
+
+  {
+    auto reader = FdbReader();
+
+    auto start = Sample::now();
+    if (!reader.open(argv[1]))
+    {
+      std::fprintf(stderr, "fugue-reader-bench: could not open `%s`\n", argv[1]);
+      return 1;
+    }
+
+    if (!reader.verify_all())
+    {
+      std::fprintf(stderr, "fugue-reader-bench: `%s` is not a valid FDB\n", argv[1]);
+      return 1;
+    }
+    report("full", "open", start, Sample::now());
+
+    checksum += run_queries(reader, queries, "full");
+  }
+
+  {
+    auto reader = FdbReader();
+
+    auto start = Sample::now();
+    if (!reader.open(argv[1]))
+    {
+      std::fprintf(stderr, "fugue-reader-bench: could not open `%s`\n", argv[1]);
+      return 1;
+    }
+    report("lazy", "open", start, Sample::now());
+
+    checksum -= run_queries(reader, queries, "lazy");
+  }
+
+  // both modes answer the same queries
+  if (checksum != 0)
+  {
+    std::fprintf(stderr, "fugue-reader-bench: results differ between modes\n");
+    return 1;
+  }
+
+  return 0;
+}
@@ -69,7 +69,7 @@ include(FindPackageHandleStandardArgs)
 find_path(IdaSdk_DIR NAMES include/pro.h
                      HINTS ENV IDASDK_ROOT ${IdaSdk_ROOT_DIR}
                      PATHS ${CMAKE_CURRENT_LIST_DIR}/../third-party/idasdk
-                     PATH_SUFFIXES idasdk idasdk70 idasdk72 idasdk73 idasdk74 idasdk75 idasdk76 idasdk77
+                     PATH_SUFFIXES idasdk idasdk70 idasdk72 idasdk73 idasdk74 idasdk75 idasdk76 idasdk77 idasdk80 idasdk90
                      DOC "Location of the IDA SDK"
                      NO_DEFAULT_PATH)
 set(IdaSdk_INCLUDE_DIRS ${IdaSdk_DIR}/include)
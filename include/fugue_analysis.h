@@ -0,0 +1,666 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace fugue
+{
+
+  const uint32_t NO_BLOCK = std::numeric_limits<uint32_t>::max();
+
+  // calls `body(state, i)` for each `i` below `count` across up to `threads`
+  // threads (including the caller), where each thread creates its own
+  // `state` with `make_state()`; indices are handed out one at a time, so a
+  // few expensive items do not hold up the rest
+  template <typename MakeState, typename Body>
+  inline void parallel_for(size_t count, size_t threads, MakeState make_state, Body body)
+  {
+    auto next = std::atomic<size_t>(0);
+
+    auto worker = [&] {
+      auto state = make_state();
+      for (auto i = next++; i < count; i = next++)
+      {
+        body(state, i);
+      }
+    };
+
+    threads = std::max<size_t>(1, std::min(threads, count));
+
+    auto pool = std::vector<std::thread>();
+    for (size_t i = 1; i < threads; ++i)
+    {
+      pool.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto &thread : pool)
+    {
+      thread.join();
+    }
+  }
+
+  // control-flow graphs of all exported functions in compressed sparse row
+  // form; blocks are numbered from zero within each function, and functions
+  // are stored in id order
+  struct FlowGraphs
+  {
+    // offset of each function's first block; the final entry is the total
+    std::vector<uint32_t> blocks{0};
+    std::vector<uint32_t> entries;
+
+    // offset of each block's first successor; the final entry is the total
+    std::vector<uint32_t> edges{0};
+    std::vector<uint32_t> succs;
+
+    // NOTE: `block_edges` holds (source, target) pairs and is reordered
+    inline void add_function(uint32_t count, uint32_t entry, std::vector<std::pair<uint32_t, uint32_t>> &block_edges)
+    {
+      std::stable_sort(std::begin(block_edges), std::end(block_edges), [](auto const &l, auto const &r) {
+        return l.first < r.first;
+      });
+
+      auto edge = std::begin(block_edges);
+      for (uint32_t block = 0; block != count; ++block)
+      {
+        for (; edge != std::end(block_edges) && edge->first == block; ++edge)
+        {
+          succs.push_back(edge->second);
+        }
+        edges.push_back(static_cast<uint32_t>(std::size(succs)));
+      }
+
+      blocks.push_back(blocks.back() + count);
+      entries.push_back(entry);
+    }
+
+    inline size_t function_count() const
+    {
+      return std::size(entries);
+    }
+
+    inline size_t block_count() const
+    {
+      return blocks.back();
+    }
+  };
+
+  // per-block results, stored at each function's block offset; block indices
+  // are local to their function and NO_BLOCK marks their absence
+  struct Dominators
+  {
+    Dominators(size_t blocks)
+        : idom(blocks, NO_BLOCK), ipdom(blocks, NO_BLOCK), loop_header(blocks, NO_BLOCK), loop_depth(blocks, 0)
+    {
+    }
+
+    std::vector<uint32_t> idom;
+    std::vector<uint32_t> ipdom;
+
+    // innermost natural loop containing each block (a header is within its
+    // own loop), and the number of natural loops containing it
+    std::vector<uint32_t> loop_header;
+    std::vector<uint16_t> loop_depth;
+  };
+
+  // computes immediate dominators and post-dominators using the iterative
+  // algorithm of Cooper, Harvey and Kennedy, and natural loops from the back
+  // edges it identifies; scratch space is retained between functions, so a
+  // single instance allocates only when it meets a larger function than any
+  // before
+  class DominatorAnalysis
+  {
+  public:
+    inline void run(FlowGraphs const &graphs, size_t function, Dominators &out)
+    {
+      auto first = graphs.blocks[function];
+      auto count = graphs.blocks[function + 1] - first;
+      auto entry = graphs.entries[function];
+
+      if (count == 0 || entry >= count)
+      {
+        return;
+      }
+
+      // forward graph
+      auto base = graphs.edges[first];
+      succ_offsets.resize(count + 1);
+      for (uint32_t block = 0; block <= count; ++block)
+      {
+        succ_offsets[block] = graphs.edges[first + block] - base;
+      }
+      auto succ = Csr{succ_offsets.data(), graphs.succs.data() + base};
+
+      transpose(succ, count, pred_offsets, pred_targets);
+      auto pred = Csr{pred_offsets.data(), pred_targets.data()};
+
+      auto idom = out.idom.data() + first;
+      immediate_dominators(succ, pred, count, entry, idom);
+
+      find_loops(pred, count, entry, idom, out.loop_header.data() + first, out.loop_depth.data() + first);
+      idom[entry] = NO_BLOCK;
+
+      // reverse graph, with a virtual exit (numbered `count`) succeeding
+      // every block without successors
+      auto exit = count;
+
+      rsucc_offsets.resize(count + 2);
+      rsucc_targets.clear();
+      rpred_offsets.resize(count + 2);
+      rpred_targets.clear();
+
+      for (uint32_t block = 0; block != count; ++block)
+      {
+        rsucc_offsets[block] = static_cast<uint32_t>(std::size(rsucc_targets));
+        rsucc_targets.insert(std::end(rsucc_targets), pred.begin(block), pred.end(block));
+
+        rpred_offsets[block] = static_cast<uint32_t>(std::size(rpred_targets));
+        rpred_targets.insert(std::end(rpred_targets), succ.begin(block), succ.end(block));
+        if (succ.begin(block) == succ.end(block))
+        {
+          rpred_targets.push_back(exit);
+        }
+      }
+
+      rsucc_offsets[exit] = static_cast<uint32_t>(std::size(rsucc_targets));
+      for (uint32_t block = 0; block != count; ++block)
+      {
+        if (succ.begin(block) == succ.end(block))
+        {
+          rsucc_targets.push_back(block);
+        }
+      }
+      rsucc_offsets[exit + 1] = static_cast<uint32_t>(std::size(rsucc_targets));
+
+      rpred_offsets[exit] = static_cast<uint32_t>(std::size(rpred_targets));
+      rpred_offsets[exit + 1] = rpred_offsets[exit];
+
+      ipdom.resize(count + 1);
+      immediate_dominators(
+          Csr{rsucc_offsets.data(), rsucc_targets.data()},
+          Csr{rpred_offsets.data(), rpred_targets.data()},
+          count + 1,
+          exit,
+          ipdom.data());
+
+      for (uint32_t block = 0; block != count; ++block)
+      {
+        out.ipdom[first + block] = ipdom[block] == exit ? NO_BLOCK : ipdom[block];
+      }
+    }
+
+  private:
+    struct Csr
+    {
+      const uint32_t *offsets;
+      const uint32_t *targets;
+
+      inline const uint32_t *begin(uint32_t node) const { return targets + offsets[node]; }
+      inline const uint32_t *end(uint32_t node) const { return targets + offsets[node + 1]; }
+    };
+
+    inline void transpose(Csr const &graph, uint32_t count, std::vector<uint32_t> &offsets, std::vector<uint32_t> &targets)
+    {
+      offsets.assign(count + 1, 0);
+      for (auto edge = graph.begin(0); edge != graph.end(count - 1); ++edge)
+      {
+        ++offsets[*edge + 1];
+      }
+
+      for (uint32_t node = 0; node != count; ++node)
+      {
+        offsets[node + 1] += offsets[node];
+      }
+
+      targets.resize(offsets[count]);
+      cursor.assign(std::begin(offsets), std::end(offsets) - 1);
+      for (uint32_t node = 0; node != count; ++node)
+      {
+        for (auto edge = graph.begin(node); edge != graph.end(node); ++edge)
+        {
+          targets[cursor[*edge]++] = node;
+        }
+      }
+    }
+
+    // NOTE: leaves `postorder` holding the nodes reachable from `root` in
+    // postorder and `number` their postorder numbers (NO_BLOCK if
+    // unreachable); the root's immediate dominator is itself
+    inline void immediate_dominators(Csr const &succ, Csr const &pred, uint32_t count, uint32_t root, uint32_t *idom)
+    {
+      number.assign(count, NO_BLOCK);
+      postorder.clear();
+      stack.clear();
+
+      number[root] = NO_BLOCK - 1;
+      stack.emplace_back(root, 0);
+
+      while (!stack.empty())
+      {
+        auto &[node, next] = stack.back();
+        auto edge = succ.begin(node) + next;
+
+        if (edge != succ.end(node))
+        {
+          ++next;
+          if (number[*edge] == NO_BLOCK)
+          {
+            number[*edge] = NO_BLOCK - 1;
+            stack.emplace_back(*edge, 0);
+          }
+        }
+        else
+        {
+          number[node] = static_cast<uint32_t>(std::size(postorder));
+          postorder.push_back(node);
+          stack.pop_back();
+        }
+      }
+
+      std::fill(idom, idom + count, NO_BLOCK);
+      idom[root] = root;
+
+      auto intersect = [&](uint32_t a, uint32_t b) {
+        while (a != b)
+        {
+          while (number[a] < number[b])
+            a = idom[a];
+          while (number[b] < number[a])
+            b = idom[b];
+        }
+        return a;
+      };
+
+      for (auto changed = true; changed;)
+      {
+        changed = false;
+        for (auto node = std::rbegin(postorder); node != std::rend(postorder); ++node)
+        {
+          if (*node == root)
+          {
+            continue;
+          }
+
+          auto dominator = NO_BLOCK;
+          for (auto edge = pred.begin(*node); edge != pred.end(*node); ++edge)
+          {
+            if (idom[*edge] == NO_BLOCK)
+            {
+              continue;
+            }
+            dominator = dominator == NO_BLOCK ? *edge : intersect(*edge, dominator);
+          }
+
+          if (idom[*node] != dominator)
+          {
+            idom[*node] = dominator;
+            changed = true;
+          }
+        }
+      }
+    }
+
+    // numbers the dominator tree rooted at `entry` on entering and leaving
+    // each node, such that `a` dominates `b` iff b's interval is within a's
+    inline void number_dominator_tree(uint32_t count, uint32_t entry, const uint32_t *idom)
+    {
+      tree_offsets.assign(count + 1, 0);
+      for (auto node : postorder)
+      {
+        if (node != entry)
+        {
+          ++tree_offsets[idom[node] + 1];
+        }
+      }
+
+      for (uint32_t node = 0; node != count; ++node)
+      {
+        tree_offsets[node + 1] += tree_offsets[node];
+      }
+
+      tree_children.resize(tree_offsets[count]);
+      cursor.assign(std::begin(tree_offsets), std::end(tree_offsets) - 1);
+      for (auto node : postorder)
+      {
+        if (node != entry)
+        {
+          tree_children[cursor[idom[node]]++] = node;
+        }
+      }
+
+      enter.assign(count, 0);
+      leave.assign(count, 0);
+      stack.clear();
+
+      auto clock = uint32_t(0);
+      enter[entry] = clock++;
+      stack.emplace_back(entry, tree_offsets[entry]);
+
+      while (!stack.empty())
+      {
+        auto &[node, next] = stack.back();
+        if (next != tree_offsets[node + 1])
+        {
+          auto child = tree_children[next++];
+          enter[child] = clock++;
+          stack.emplace_back(child, tree_offsets[child]);
+        }
+        else
+        {
+          leave[node] = clock++;
+          stack.pop_back();
+        }
+      }
+    }
+
+    // NOTE: expects `postorder` and `number` as left by a forward run of
+    // immediate_dominators; headers are visited in reverse postorder, so
+    // inner loops are visited after the loops enclosing them; only
+    // retreating edges (to a node no later in postorder) can be back edges,
+    // so dominance is tested only for those
+    inline void find_loops(Csr const &pred, uint32_t count, uint32_t entry, const uint32_t *idom, uint32_t *header, uint16_t *depth)
+    {
+      number_dominator_tree(count, entry, idom);
+
+      auto dominates = [&](uint32_t a, uint32_t b) {
+        return enter[a] <= enter[b] && leave[b] <= leave[a];
+      };
+
+      mark.assign(count, NO_BLOCK);
+
+      for (auto node = std::rbegin(postorder); node != std::rend(postorder); ++node)
+      {
+        auto head = *node;
+
+        body.clear();
+        for (auto edge = pred.begin(head); edge != pred.end(head); ++edge)
+        {
+          if (number[*edge] == NO_BLOCK || number[*edge] > number[head] || !dominates(head, *edge))
+          {
+            continue;
+          }
+
+          if (body.empty())
+          {
+            mark[head] = head;
+            body.push_back(head);
+          }
+
+          if (mark[*edge] != head)
+          {
+            mark[*edge] = head;
+            body.push_back(*edge);
+          }
+        }
+
+        // walk backwards from the latches; `body` doubles as the worklist
+        for (size_t i = 1; i < std::size(body); ++i)
+        {
+          for (auto edge = pred.begin(body[i]); edge != pred.end(body[i]); ++edge)
+          {
+            if (number[*edge] != NO_BLOCK && mark[*edge] != head)
+            {
+              mark[*edge] = head;
+              body.push_back(*edge);
+            }
+          }
+        }
+
+        for (auto block : body)
+        {
+          header[block] = head;
+          if (depth[block] != std::numeric_limits<uint16_t>::max())
+          {
+            ++depth[block];
+          }
+        }
+      }
+    }
+
+    std::vector<uint32_t> succ_offsets;
+    std::vector<uint32_t> pred_offsets;
+    std::vector<uint32_t> pred_targets;
+    std::vector<uint32_t> rsucc_offsets;
+    std::vector<uint32_t> rsucc_targets;
+    std::vector<uint32_t> rpred_offsets;
+    std::vector<uint32_t> rpred_targets;
+    std::vector<uint32_t> ipdom;
+    std::vector<uint32_t> cursor;
+
+    std::vector<uint32_t> number;
+    std::vector<uint32_t> postorder;
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+
+    std::vector<uint32_t> tree_offsets;
+    std::vector<uint32_t> tree_children;
+    std::vector<uint32_t> enter;
+    std::vector<uint32_t> leave;
+
+    std::vector<uint32_t> mark;
+    std::vector<uint32_t> body;
+  };
+
+  // analyses all functions of `graphs` across `threads` workers
+  inline Dominators dominators(FlowGraphs const &graphs, size_t threads)
+  {
+    auto result = Dominators(graphs.block_count());
+
+    parallel_for(
+        graphs.function_count(),
+        threads,
+        [] { return DominatorAnalysis(); },
+        [&](DominatorAnalysis &analysis, size_t function) { analysis.run(graphs, function, result); });
+
+    return result;
+  }
+
+  // strongly connected components of the call graph, numbered bottom-up:
+  // components are grouped into levels, where each component calls only
+  // components of lower levels (or itself), so that the components of a
+  // level can be processed concurrently once those of all lower levels are
+  struct CallGraphSccs
+  {
+    // per function
+    std::vector<uint32_t> function_scc;
+
+    // per component; each component's functions are listed in
+    // `scc_functions` (in id order) from its offset
+    std::vector<uint32_t> scc_level;
+    std::vector<uint32_t> scc_function_offsets;
+    std::vector<uint32_t> scc_functions;
+
+    // offset of each level's first component; the final entry is the total
+    std::vector<uint32_t> level_offsets{0};
+  };
+
+  // NOTE: `edges` holds (caller, callee) pairs and is reordered; components
+  // are found using an iterative form of Tarjan's algorithm, which emits
+  // each component after all those it reaches
+  inline CallGraphSccs call_graph_sccs(size_t functions, std::vector<std::pair<uint32_t, uint32_t>> &edges)
+  {
+    auto result = CallGraphSccs();
+    auto count = static_cast<uint32_t>(functions);
+
+    edges.erase(
+        std::remove_if(std::begin(edges), std::end(edges), [&](auto const &edge) {
+          return edge.first >= count || edge.second >= count;
+        }),
+        std::end(edges));
+
+    std::sort(std::begin(edges), std::end(edges));
+    edges.erase(std::unique(std::begin(edges), std::end(edges)), std::end(edges));
+
+    auto offsets = std::vector<uint32_t>(count + 1, 0);
+    for (auto const &edge : edges)
+    {
+      ++offsets[edge.first + 1];
+    }
+
+    for (uint32_t node = 0; node != count; ++node)
+    {
+      offsets[node + 1] += offsets[node];
+    }
+
+    // components in emission order
+    auto component = std::vector<uint32_t>(count, NO_BLOCK);
+    auto components = uint32_t(0);
+
+    auto index = std::vector<uint32_t>(count, NO_BLOCK);
+    auto lowlink = std::vector<uint32_t>(count, 0);
+    auto on_stack = std::vector<bool>(count, false);
+    auto stack = std::vector<uint32_t>();
+    auto calls = std::vector<std::pair<uint32_t, uint32_t>>();
+    auto next_index = uint32_t(0);
+
+    for (uint32_t root = 0; root != count; ++root)
+    {
+      if (index[root] != NO_BLOCK)
+      {
+        continue;
+      }
+
+      index[root] = lowlink[root] = next_index++;
+      stack.push_back(root);
+      on_stack[root] = true;
+      calls.emplace_back(root, offsets[root]);
+
+      while (!calls.empty())
+      {
+        auto &[node, edge] = calls.back();
+
+        if (edge != offsets[node + 1])
+        {
+          auto callee = edges[edge++].second;
+          if (index[callee] == NO_BLOCK)
+          {
+            index[callee] = lowlink[callee] = next_index++;
+            stack.push_back(callee);
+            on_stack[callee] = true;
+            calls.emplace_back(callee, offsets[callee]);
+          }
+          else if (on_stack[callee])
+          {
+            lowlink[node] = std::min(lowlink[node], index[callee]);
+          }
+          continue;
+        }
+
+        auto done = node;
+        calls.pop_back();
+
+        if (!calls.empty())
+        {
+          auto caller = calls.back().first;
+          lowlink[caller] = std::min(lowlink[caller], lowlink[done]);
+        }
+
+        if (lowlink[done] == index[done])
+        {
+          uint32_t member;
+          do
+          {
+            member = stack.back();
+            stack.pop_back();
+            on_stack[member] = false;
+            component[member] = components;
+          } while (member != done);
+          ++components;
+        }
+      }
+    }
+
+    // levels, in emission order, as callees' components are emitted first
+    auto members = std::vector<uint32_t>(count);
+    auto member_offsets = std::vector<uint32_t>(components + 1, 0);
+    for (uint32_t node = 0; node != count; ++node)
+    {
+      ++member_offsets[component[node] + 1];
+    }
+
+    for (uint32_t c = 0; c != components; ++c)
+    {
+      member_offsets[c + 1] += member_offsets[c];
+    }
+
+    auto cursor = std::vector<uint32_t>(std::begin(member_offsets), std::end(member_offsets) - 1);
+    for (uint32_t node = 0; node != count; ++node)
+    {
+      members[cursor[component[node]]++] = node;
+    }
+
+    auto level = std::vector<uint32_t>(components, 0);
+    auto levels = uint32_t(0);
+    for (uint32_t c = 0; c != components; ++c)
+    {
+      for (auto m = member_offsets[c]; m != member_offsets[c + 1]; ++m)
+      {
+        auto node = members[m];
+        for (auto e = offsets[node]; e != offsets[node + 1]; ++e)
+        {
+          auto callee = component[edges[e].second];
+          if (callee != c)
+          {
+            level[c] = std::max(level[c], level[callee] + 1);
+          }
+        }
+      }
+      levels = std::max(levels, level[c] + 1);
+    }
+
+    // renumber by level, then emission order
+    result.level_offsets.assign(levels + 1, 0);
+    for (uint32_t c = 0; c != components; ++c)
+    {
+      ++result.level_offsets[level[c] + 1];
+    }
+
+    for (uint32_t l = 0; l != levels; ++l)
+    {
+      result.level_offsets[l + 1] += result.level_offsets[l];
+    }
+
+    auto renumber = std::vector<uint32_t>(components);
+    cursor.assign(std::begin(result.level_offsets), std::end(result.level_offsets) - 1);
+    for (uint32_t c = 0; c != components; ++c)
+    {
+      renumber[c] = cursor[level[c]]++;
+    }
+
+    result.function_scc.resize(count);
+    for (uint32_t node = 0; node != count; ++node)
+    {
+      result.function_scc[node] = renumber[component[node]];
+    }
+
+    result.scc_level.resize(components);
+    result.scc_function_offsets.resize(components);
+    result.scc_functions.resize(count);
+
+    auto placed = uint32_t(0);
+    auto order = std::vector<uint32_t>(components);
+    for (uint32_t c = 0; c != components; ++c)
+    {
+      order[renumber[c]] = c;
+    }
+
+    for (uint32_t scc = 0; scc != components; ++scc)
+    {
+      auto c = order[scc];
+      result.scc_level[scc] = level[c];
+      result.scc_function_offsets[scc] = placed;
+      for (auto m = member_offsets[c]; m != member_offsets[c + 1]; ++m)
+      {
+        result.scc_functions[placed++] = members[m];
+      }
+    }
+
+    return result;
+  }
+
+}; // namespace fugue
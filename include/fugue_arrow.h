@@ -0,0 +1,240 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <flatbuffers/flatbuffers.h>
+
+namespace fugue
+{
+  namespace arrow
+  {
+
+    // NOTE: the Arrow IPC metadata is itself a FlatBuffer; we encode the
+    // handful of tables we need directly rather than depending on Arrow's
+    // generated schema. Field slots follow Schema.fbs and Message.fbs.
+    namespace format
+    {
+      const int16_t METADATA_V5 = 4;
+
+      const uint8_t TYPE_INT = 2;
+      const uint8_t TYPE_UTF8 = 5;
+
+      const uint8_t HEADER_SCHEMA = 1;
+      const uint8_t HEADER_RECORD_BATCH = 3;
+
+      constexpr flatbuffers::voffset_t slot(flatbuffers::voffset_t id)
+      {
+        return static_cast<flatbuffers::voffset_t>(4 + 2 * id);
+      }
+
+      FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(8) FieldNode
+      {
+        int64_t length;
+        int64_t null_count;
+      };
+      FLATBUFFERS_STRUCT_END(FieldNode, 16);
+
+      FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(8) Buffer
+      {
+        int64_t offset;
+        int64_t length;
+      };
+      FLATBUFFERS_STRUCT_END(Buffer, 16);
+    }; // namespace format
+
+    class Table
+    {
+    public:
+      template <typename T>
+      inline void column(const std::string &name, const std::vector<T> &values)
+      {
+        static_assert(std::is_integral<T>::value, "fixed-width columns must be integral");
+
+        auto column = Column{name, format::TYPE_INT, static_cast<int32_t>(8 * sizeof(T)), std::is_signed<T>::value, std::size(values), {}};
+        column.buffers.resize(2); // validity (omitted), values
+        column.buffers[1].resize(sizeof(T) * std::size(values));
+        if (!values.empty())
+        {
+          std::memcpy(column.buffers[1].data(), values.data(), std::size(column.buffers[1]));
+        }
+
+        columns.emplace_back(std::move(column));
+      }
+
+      inline void column(const std::string &name, const std::vector<std::string> &values)
+      {
+        auto column = Column{name, format::TYPE_UTF8, 0, false, std::size(values), {}};
+        column.buffers.resize(3); // validity (omitted), offsets, data
+
+        auto offsets = std::vector<int32_t>();
+        offsets.reserve(std::size(values) + 1);
+        offsets.push_back(0);
+
+        auto &data = column.buffers[2];
+        for (auto const &value : values)
+        {
+          data.insert(std::end(data), std::begin(value), std::end(value));
+          offsets.push_back(static_cast<int32_t>(std::size(data)));
+        }
+
+        column.buffers[1].resize(sizeof(int32_t) * std::size(offsets));
+        std::memcpy(column.buffers[1].data(), offsets.data(), std::size(column.buffers[1]));
+
+        columns.emplace_back(std::move(column));
+      }
+
+      inline bool empty() const
+      {
+        return columns.empty();
+      }
+
+      inline size_t length() const
+      {
+        return columns.empty() ? 0 : columns.front().length;
+      }
+
+      // serialises the table as an Arrow IPC stream: a schema message, a
+      // single record batch and the end-of-stream marker
+      inline std::vector<uint8_t> finish() const
+      {
+        auto stream = std::vector<uint8_t>();
+        write_message(stream, schema_message(), {});
+
+        auto body = std::vector<uint8_t>();
+        auto batch = record_batch_message(body);
+        write_message(stream, batch, body);
+
+        const uint32_t eos[2] = {0xffffffffU, 0};
+        append(stream, eos, sizeof(eos));
+
+        return stream;
+      }
+
+    private:
+      struct Column
+      {
+        std::string name;
+        uint8_t type;
+        int32_t bit_width;
+        bool is_signed;
+        size_t length;
+        std::vector<std::vector<uint8_t>> buffers;
+      };
+
+      static inline size_t padding(size_t size)
+      {
+        return (8 - size % 8) % 8;
+      }
+
+      static inline void append(std::vector<uint8_t> &out, const void *data, size_t size)
+      {
+        auto bytes = static_cast<const uint8_t *>(data);
+        out.insert(std::end(out), bytes, bytes + size);
+      }
+
+      static inline void write_message(std::vector<uint8_t> &out, const flatbuffers::FlatBufferBuilder &fbb, const std::vector<uint8_t> &body)
+      {
+        auto size = fbb.GetSize();
+        auto padded = static_cast<int32_t>(size + padding(size));
+
+        const uint32_t continuation = 0xffffffffU;
+        append(out, &continuation, sizeof(continuation));
+        append(out, &padded, sizeof(padded));
+        append(out, fbb.GetBufferPointer(), size);
+        out.resize(std::size(out) + padding(size));
+
+        append(out, body.data(), std::size(body));
+      }
+
+      inline flatbuffers::Offset<void> field(flatbuffers::FlatBufferBuilder &fbb, const Column &column) const
+      {
+        auto name = fbb.CreateString(column.name);
+
+        auto type_start = fbb.StartTable();
+        if (column.type == format::TYPE_INT)
+        {
+          fbb.AddElement<int32_t>(format::slot(0), column.bit_width, 0);
+          fbb.AddElement<uint8_t>(format::slot(1), column.is_signed, 0);
+        }
+        auto type = flatbuffers::Offset<void>(fbb.EndTable(type_start));
+
+        auto children = fbb.CreateVector(std::vector<flatbuffers::Offset<void>>());
+
+        auto start = fbb.StartTable();
+        fbb.AddOffset(format::slot(0), name);
+        fbb.AddElement<uint8_t>(format::slot(2), column.type, 0);
+        fbb.AddOffset(format::slot(3), type);
+        fbb.AddOffset(format::slot(5), children);
+        return flatbuffers::Offset<void>(fbb.EndTable(start));
+      }
+
+      inline flatbuffers::Offset<void> message(flatbuffers::FlatBufferBuilder &fbb, uint8_t header_type, flatbuffers::Offset<void> header, int64_t body_length) const
+      {
+        auto start = fbb.StartTable();
+        fbb.AddElement<int64_t>(format::slot(3), body_length, 0);
+        fbb.AddOffset(format::slot(2), header);
+        fbb.AddElement<int16_t>(format::slot(0), format::METADATA_V5, 0);
+        fbb.AddElement<uint8_t>(format::slot(1), header_type, 0);
+        return flatbuffers::Offset<void>(fbb.EndTable(start));
+      }
+
+      inline flatbuffers::FlatBufferBuilder schema_message() const
+      {
+        auto fbb = flatbuffers::FlatBufferBuilder();
+
+        auto fields = std::vector<flatbuffers::Offset<void>>();
+        for (auto const &column : columns)
+        {
+          fields.push_back(field(fbb, column));
+        }
+        auto fieldsv = fbb.CreateVector(fields);
+
+        auto start = fbb.StartTable();
+        fbb.AddOffset(format::slot(1), fieldsv);
+        auto schema = flatbuffers::Offset<void>(fbb.EndTable(start));
+
+        fbb.Finish(message(fbb, format::HEADER_SCHEMA, schema, 0));
+        return fbb;
+      }
+
+      inline flatbuffers::FlatBufferBuilder record_batch_message(std::vector<uint8_t> &body) const
+      {
+        auto fbb = flatbuffers::FlatBufferBuilder();
+
+        auto nodes = std::vector<format::FieldNode>();
+        auto buffers = std::vector<format::Buffer>();
+        int64_t length = columns.empty() ? 0 : static_cast<int64_t>(columns.front().length);
+
+        for (auto const &column : columns)
+        {
+          nodes.push_back(format::FieldNode{static_cast<int64_t>(column.length), 0});
+          for (auto const &buffer : column.buffers)
+          {
+            buffers.push_back(format::Buffer{static_cast<int64_t>(std::size(body)), static_cast<int64_t>(std::size(buffer))});
+            append(body, buffer.data(), std::size(buffer));
+            body.resize(std::size(body) + padding(std::size(buffer)));
+          }
+        }
+
+        auto nodesv = fbb.CreateVectorOfStructs(nodes.data(), std::size(nodes));
+        auto buffersv = fbb.CreateVectorOfStructs(buffers.data(), std::size(buffers));
+
+        auto start = fbb.StartTable();
+        fbb.AddElement<int64_t>(format::slot(0), length, 0);
+        fbb.AddOffset(format::slot(1), nodesv);
+        fbb.AddOffset(format::slot(2), buffersv);
+        auto batch = flatbuffers::Offset<void>(fbb.EndTable(start));
+
+        fbb.Finish(message(fbb, format::HEADER_RECORD_BATCH, batch, static_cast<int64_t>(std::size(body))));
+        return fbb;
+      }
+
+      std::vector<Column> columns;
+    };
+
+  }; // namespace arrow
+};   // namespace fugue
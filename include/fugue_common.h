@@ -1,13 +1,20 @@
 #pragma once
 
 #include <algorithm>
+#include <cerrno>
 #include <chrono>
 #include <cctype>
 #include <cstdint>
 #include <sstream>
 #include <exception>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include <fugue_analysis.h>
 #include <fugue_generated.h>
 
 #ifdef _WIN32
@@ -29,9 +36,28 @@ namespace fugue
   const int EXIT_IMPORT_ERROR = 102;
   const int EXIT_UNSUPPORTED_ERROR = 103;
   const int EXIT_REBASE_ERROR = 104;
+  const int EXIT_FILTER_ERROR = 105;
 
   uint64_t start_timestamp = 0;
 
+  // NOTE: sizes are 64-bit throughout, but the FDB schema's are 32-bit;
+  // larger sizes are stored as UINT32_MAX, and in full in the `large_sizes`
+  // auxiliary table
+  inline uint32_t saturate32(uint64_t value)
+  {
+    return static_cast<uint32_t>(std::min<uint64_t>(value, std::numeric_limits<uint32_t>::max()));
+  }
+
+  enum LargeSizeKind : uint8_t
+  {
+    LARGE_SIZE_INPUT = 0,
+    LARGE_SIZE_SEGMENT = 1,
+    LARGE_SIZE_BLOCK = 2,
+  };
+
+  // bytes of segment contents streamed out of line at once
+  const size_t PAYLOAD_CHUNK = size_t(64) << 20;
+
   struct BasicBlock;
   struct Function;
   struct Segment;
@@ -89,6 +115,18 @@ namespace fugue
     return std::equal(std::begin(opt), std::end(opt), "true", [](char a, char b) { return tolower(a) == tolower(b); });
   }
 
+  inline std::vector<std::string> split_opt(const std::string &opt, char sep = ',')
+  {
+    auto parts = std::vector<std::string>();
+    auto ss = std::stringstream(opt);
+    auto part = std::string();
+    while (std::getline(ss, part, sep))
+    {
+      parts.push_back(part);
+    }
+    return parts;
+  }
+
   inline bool file_exists(const char *path)
   {
 #ifdef _WIN32
@@ -113,48 +151,56 @@ namespace fugue
     return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
   }
 
-  template <typename Architecture>
-  class ProjectBuilder
+  inline int open_for_writing(const std::string &path)
   {
-  public:
-    ProjectBuilder() : arches{}, message{1024}, project_aux{1024} {
-      project_aux_off = project_aux.StartMap();
+#ifdef _WIN32
+    int fd = -1;
+    errno_t err = _sopen_s(&fd, path.c_str(), _O_CREAT | _O_TRUNC | _O_BINARY | _O_WRONLY, _SH_DENYNO, _S_IREAD | _S_IWRITE);
+    if (err != 0)
+    {
+      fd = -1;
     }
+#else
+    int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_BINARY | O_WRONLY, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+#endif
 
-    bool write_to_file(const std::string &path)
+    if (fd < 0)
     {
+      msg("Fugue IDB exporter: could not open file for writing\n");
+    }
+    return fd;
+  }
+
+  inline void close_file(int fd)
+  {
 #ifdef _WIN32
-      int fd = 0;
-      errno_t err = _sopen_s(&fd, path.c_str(), _O_CREAT | _O_TRUNC | _O_BINARY | _O_WRONLY, _SH_DENYNO, _S_IREAD | _S_IWRITE);
-      if (err != 0)
-      {
-        msg("Fugue IDB exporter: could not open file for writing\n");
-        return false;
-      }
+    _close(fd);
 #else
-      int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_BINARY | O_WRONLY, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
-      if (fd < 0)
-      {
-        msg("Fugue IDB exporter: could not open file for writing\n");
-        return false;
-      }
+    close(fd);
 #endif
+  }
 
-      build_arches();
-      build_project();
-
-      auto success = false;
-      uint8_t *buf = message.GetBufferPointer();
-      size_t size = message.GetSize();
+  // NOTE: writes are issued in chunks of at most 1 GiB, as a single write is
+  // capped below 2 GiB on Linux and takes a 32-bit size on Windows
+  inline bool write_all(int fd, const uint8_t *buf, size_t size)
+  {
+    const size_t chunk = size_t(1) << 30;
 
+    while (size != 0)
+    {
+      auto amount = std::min(size, chunk);
 #ifdef _WIN32
-      ssize_t result = _write(fd, buf, size);
+      auto result = _write(fd, buf, static_cast<unsigned int>(amount));
 #else
-      ssize_t result = write(fd, buf, size);
+      auto result = write(fd, buf, amount);
 #endif
-      if (static_cast<size_t>(result) == size) {
-        success = true;
-      } else {
+      if (result < 0 && errno == EINTR)
+      {
+        continue;
+      }
+
+      if (result <= 0)
+      {
         msg("Fugue IDB exporter: ");
 
         char errbuf[80] = { 0 };
@@ -171,18 +217,234 @@ namespace fugue
           msg("could not write serialised database to file\n");
         }
 
-        success = false;
+        return false;
       }
 
-#ifdef _WIN32
-      _close(fd);
-#else
-      close(fd);
-#endif
+      buf += result;
+      size -= static_cast<size_t>(result);
+    }
+
+    return true;
+  }
+
+  inline bool write_buffer_to_file(const std::string &path, const uint8_t *buf, size_t size)
+  {
+    auto fd = open_for_writing(path);
+    if (fd < 0)
+    {
+      return false;
+    }
+
+    auto success = write_all(fd, buf, size);
+    close_file(fd);
+
+    return success;
+  }
+
+  // NOTE: streams segment contents stored out of line to a file alongside
+  // the export; contents are located by offset and size
+  class SegmentPayloads
+  {
+  public:
+    SegmentPayloads() = default;
+
+    SegmentPayloads(const SegmentPayloads &) = delete;
+    SegmentPayloads &operator=(const SegmentPayloads &) = delete;
+
+    ~SegmentPayloads()
+    {
+      close();
+    }
+
+    inline bool open(const std::string &path)
+    {
+      close();
+      fd = open_for_writing(path);
+      offset = 0;
+      return fd >= 0;
+    }
+
+    inline bool is_open() const
+    {
+      return fd >= 0;
+    }
+
+    inline bool append(const uint8_t *buf, size_t size)
+    {
+      if (fd < 0 || !write_all(fd, buf, size))
+      {
+        return false;
+      }
+      offset += size;
+      return true;
+    }
+
+    inline uint64_t size() const
+    {
+      return offset;
+    }
+
+    inline void close()
+    {
+      if (fd >= 0)
+      {
+        close_file(fd);
+        fd = -1;
+      }
+    }
+
+  private:
+    int fd = -1;
+    uint64_t offset = 0;
+  };
+
+  // NOTE: interns strings into a contiguous byte pool; entries are located
+  // by offset and length
+  class StringPool
+  {
+  public:
+    inline std::pair<uint32_t, uint32_t> intern(const std::string &value)
+    {
+      auto [pos, inserted] = offsets.emplace(value, static_cast<uint32_t>(std::size(pool)));
+      if (inserted)
+      {
+        pool.insert(std::end(pool), std::begin(value), std::end(value));
+      }
+      return {pos->second, static_cast<uint32_t>(std::size(value))};
+    }
+
+    inline const std::vector<uint8_t> &bytes() const
+    {
+      return pool;
+    }
+
+  private:
+    std::unordered_map<std::string, uint32_t> offsets;
+    std::vector<uint8_t> pool;
+  };
+
+  // NOTE: unsigned LEB128
+  inline void append_varint(std::vector<uint8_t> &out, uint64_t value)
+  {
+    while (value >= 0x80)
+    {
+      out.push_back(static_cast<uint8_t>(value) | 0x80);
+      value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+  }
+
+  inline uint64_t zigzag(int64_t value)
+  {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+  }
+
+  enum ConstantKind : uint8_t
+  {
+    CONSTANT_IMMEDIATE = 0,
+    CONSTANT_DISPLACEMENT = 1,
+  };
+
+  enum FunctionFlags : uint8_t
+  {
+    FUNCTION_LIBRARY = 1 << 0,
+    FUNCTION_THUNK = 1 << 1,
+    FUNCTION_NORETURN = 1 << 2,
+  };
+
+  // entries per independently decodable chunk of a delta-encoded constant
+  // index
+  const size_t CONSTANT_CHUNK = 128;
+
+  class FlatBuffersSink;
+
+  // NOTE: one output per rebase delta; auxiliary tables are recorded once
+  // and rebased as each output is built
+  template <typename Architecture, typename Sink = FlatBuffersSink>
+  class ProjectBuilder
+  {
+  public:
+    ProjectBuilder(int64_t rebase_delta = 0) : ProjectBuilder(std::vector<int64_t>{rebase_delta}) {}
+
+    ProjectBuilder(const std::vector<int64_t> &rebase_deltas) : arches{}
+    {
+      for (auto delta : rebase_deltas)
+      {
+        outputs.push_back(std::make_unique<Output>(delta));
+      }
+    }
+
+    bool write_to_file(const std::string &path)
+    {
+      return write_to_file(0, path);
+    }
+
+    // NOTE: each output's sink is released once it is written
+    bool write_to_file(size_t index, const std::string &path)
+    {
+      auto &output = *outputs[index];
+      if (!output.sink.has_value())
+      {
+        return false;
+      }
+
+      for (auto &other : outputs)
+      {
+        other->payloads.close();
+      }
+
+      prepare_project();
+
+      build_arches(output);
+      build_project(output);
+
+      auto success = output.sink->write(path);
+      output.sink.reset();
 
       return success;
     }
 
+    inline size_t output_count() const
+    {
+      return std::size(outputs);
+    }
+
+    inline Sink &output(size_t index = 0)
+    {
+      return *outputs[index]->sink;
+    }
+
+    inline bool is_rebased() const
+    {
+      return std::any_of(std::begin(outputs), std::end(outputs), [](auto const &output) {
+        return output->rebase_delta != 0;
+      });
+    }
+
+    inline bool is_rebased(size_t index) const
+    {
+      return outputs[index]->rebase_delta != 0;
+    }
+
+    // NOTE: relocates an absolute address within an output's segment contents
+    inline void rebase_word(size_t index, uint8_t *ptr, size_t size, bool is_be) const
+    {
+      uint64_t value = 0;
+      for (size_t i = 0; i < size; ++i)
+      {
+        auto shift = 8 * (is_be ? size - i - 1 : i);
+        value |= static_cast<uint64_t>(ptr[i]) << shift;
+      }
+
+      value = outputs[index]->rebased(value);
+
+      for (size_t i = 0; i < size; ++i)
+      {
+        auto shift = 8 * (is_be ? size - i - 1 : i);
+        ptr[i] = static_cast<uint8_t>(value >> shift);
+      }
+    }
+
     Id<Architecture> architecture(Architecture &&arch)
     {
       if (auto idt = arches.find(arch); idt != std::end(arches))
@@ -200,152 +462,289 @@ namespace fugue
         const std::string &input_path,
         const std::vector<uint8_t> &input_md5,
         const std::vector<uint8_t> &input_sha256,
-        uint32_t input_size,
+        uint64_t input_size,
         const std::string &exporter)
     {
-      metadata = fugue::schema::CreateMetadataDirect(
-          message,
-          input_format.c_str(),
-          input_path.c_str(),
-          &input_md5,
-          &input_sha256,
-          input_size,
-          exporter.c_str()
-      );
+      add_large_size(LARGE_SIZE_INPUT, 0, input_size);
+      for (auto &output : outputs)
+      {
+        output->sink->set_metadata(input_format, input_path, input_md5, input_sha256, input_size, exporter);
+      }
     }
 
     inline void reserve_functions(size_t amount)
     {
-      functions.resize(amount);
+      functions = amount;
+      for (auto &output : outputs)
+      {
+        output->sink->reserve_functions(amount);
+      }
+    }
+
+    // NOTE: enables computing dominators, post-dominators and natural loops
+    // from the control flow given to the builder
+    inline void set_dominators(bool enabled)
+    {
+      dominators_enabled = enabled;
+    }
+
+    // NOTE: enables computing the call graph's SCCs from the function
+    // references given to the builder
+    inline void set_call_graph(bool enabled)
+    {
+      call_graph_enabled = enabled;
+    }
+
+    // NOTE: delta-encodes the constant index (see build_constants)
+    inline void set_constant_deltas(bool enabled)
+    {
+      constant_deltas = enabled;
     }
 
     inline void reserve_function_blocks(size_t amount)
     {
-      function_blocks.clear();
-      function_blocks.resize(amount);
+      function_block_count = amount;
+      function_edges.clear();
+      for (auto &output : outputs)
+      {
+        output->sink->reserve_function_blocks(amount);
+      }
     }
 
     inline void reserve_function_refs(size_t amount)
     {
-      function_refs.clear();
-      function_refs.resize(amount);
+      for (auto &output : outputs)
+      {
+        output->sink->reserve_function_refs(amount);
+      }
     }
 
+    // NOTE: functions must be set in id order, each after its blocks
     inline void set_function(Id<Function> id, const std::string &symbol, uint64_t address, Id<BasicBlock> entry)
     {
-      auto symbol_str = message.CreateString(symbol);
-      auto fblocks = message.CreateVector(function_blocks.data(), std::size(function_blocks));
-      auto frefs = message.CreateVector(function_refs.data(), std::size(function_refs));
+      if (dominators_enabled)
+      {
+        auto entry_block = entry == Id<BasicBlock>() ? NO_BLOCK : static_cast<uint32_t>(entry.index());
+        flow_graphs.add_function(static_cast<uint32_t>(function_block_count), entry_block, function_edges);
+      }
 
-      functions[id.index()] = fugue::schema::CreateFunction(
-          message,
-          symbol_str,
-          address,
-          entry.value(),
-          fblocks,
-          frefs
-      );
+      for (auto &output : outputs)
+      {
+        output->sink->set_function(id, symbol, output->rebased(address), entry);
+      }
+    }
+
+    inline void set_function_flags(Id<Function> id, uint8_t flags)
+    {
+      function_info(id).flags = flags;
+    }
+
+    // NOTE: `target` is the address a thunk jumps to, and `target_function`
+    // the exported function there, if any
+    inline void set_function_thunk(Id<Function> id, uint64_t target, Id<Function> target_function)
+    {
+      auto &info = function_info(id);
+      info.thunk_target = target;
+      info.thunk_function = target_function.value();
+    }
+
+    // NOTE: records a FLIRT signature applied to the database and the number
+    // of functions it matched
+    inline void add_signature(const std::string &name, const std::string &title, uint32_t matches)
+    {
+      auto [name_offset, name_length] = signature_pool.intern(name);
+      auto [title_offset, title_length] = signature_pool.intern(title);
+      signature_name_offsets.push_back(name_offset);
+      signature_name_lengths.push_back(name_length);
+      signature_title_offsets.push_back(title_offset);
+      signature_title_lengths.push_back(title_length);
+      signature_matches.push_back(matches);
     }
 
     inline void reserve_block_succs(size_t amount)
     {
-      block_succs = std::vector<flatbuffers::Offset<fugue::schema::IntraRef>>(amount);
+      for (auto &output : outputs)
+      {
+        output->sink->reserve_block_succs(amount);
+      }
     }
 
     inline void reserve_block_preds(size_t amount)
     {
-      block_preds = std::vector<flatbuffers::Offset<fugue::schema::IntraRef>>(amount);
+      for (auto &output : outputs)
+      {
+        output->sink->reserve_block_preds(amount);
+      }
     }
 
-    inline void set_block(Id<BasicBlock> bid, uint64_t address, uint32_t size, Id<Architecture> arch)
+    inline void set_block(Id<BasicBlock> bid, uint64_t address, uint64_t size, Id<Architecture> arch)
     {
-      auto bpreds = message.CreateVector(block_preds.data(), std::size(block_preds));
-      auto bsuccs = message.CreateVector(block_succs.data(), std::size(block_succs));
+      add_large_size(LARGE_SIZE_BLOCK, bid.value(), size);
+      block_index.push_back(BlockIndexEntry{address, address + size, bid.value()});
+
+      for (auto &output : outputs)
+      {
+        output->sink->set_block(bid, output->rebased(address), size, arch.value());
+      }
+    }
 
-      function_blocks[bid.index()] = fugue::schema::CreateBasicBlock(
-          message,
-          address,
-          size,
-          arch.value(),
-          bpreds,
-          bsuccs
-      );
+    // NOTE: `value` is the operand's value as encoded, and is not rebased
+    inline void add_constant(uint64_t value, uint64_t address, Id<BasicBlock> bid, ConstantKind kind)
+    {
+      constants.push_back(ConstantEntry{value, address, bid.value(), kind});
     }
 
     inline void set_function_ref(Id<Function> fid, size_t index, uint64_t address, Id<Function> source, bool call)
     {
-      function_refs[index] = fugue::schema::CreateInterRefDirect(
-          message,
-          address,
-          source.value(),
-          fid.value(),
-          call
-      );
+      if (call_graph_enabled)
+      {
+        call_edges.emplace_back(source.value(), fid.value());
+      }
+
+      for (auto &output : outputs)
+      {
+        output->sink->set_function_ref(fid, index, output->rebased(address), source, call);
+      }
     }
 
     inline void set_block_pred(Id<Function> fid, Id<BasicBlock> bid, size_t index, Id<BasicBlock> source)
     {
-      block_preds[index] = fugue::schema::CreateIntraRefDirect(
-          message,
-          source.value(),
-          bid.value(),
-          fid.value()
-      );
+      for (auto &output : outputs)
+      {
+        output->sink->set_block_pred(fid, bid, index, source);
+      }
     }
 
     inline void set_block_succ(Id<Function> fid, Id<BasicBlock> bid, size_t index, Id<BasicBlock> target)
     {
-      block_succs[index] = fugue::schema::CreateIntraRefDirect(
-          message,
-          bid.value(),
-          target.value(),
-          fid.value()
-      );
+      if (dominators_enabled)
+      {
+        function_edges.emplace_back(static_cast<uint32_t>(bid.index()), static_cast<uint32_t>(target.index()));
+      }
+
+      for (auto &output : outputs)
+      {
+        output->sink->set_block_succ(fid, bid, index, target);
+      }
     }
 
     inline size_t function_count()
     {
-      auto *proj = fugue::schema::GetProject(message.GetBufferPointer());
-      return proj->functions()->size();
+      return functions;
     }
 
     inline size_t segment_count()
     {
-      auto *proj = fugue::schema::GetProject(message.GetBufferPointer());
-      return proj->segments()->size();
+      return segments;
+    }
+
+    inline void reserve_segments(size_t amount)
+    {
+      segments = amount;
+      for (auto &output : outputs)
+      {
+        output->sink->reserve_segments(amount);
+      }
+    }
+
+    inline uint8_t *reserve_segment_bytes(size_t index, size_t amount)
+    {
+      return outputs[index]->sink->reserve_segment_bytes(amount);
+    }
+
+    // NOTE: contents given to add_segment_payload are written to `path`
+    inline bool set_segment_payloads(size_t index, const std::string &path)
+    {
+      return outputs[index]->payloads.open(path);
     }
 
-    inline std::string function_names()
+    inline bool has_segment_payloads() const
     {
-      auto ss = std::stringstream();
-      auto *proj = fugue::schema::GetProject(message.GetBufferPointer());
+      return outputs[0]->payloads.is_open();
+    }
+
+    // NOTE: streams contents in chunks, each read once by `read(buf, offset,
+    // size)` and rebased by `relocate(index, buf, offset, size)` per output
+    template <typename F, typename G>
+    inline bool add_segment_payload(Id<Segment> id, uint64_t size, F read, G relocate)
+    {
+      payload_segments.push_back(id.value());
+      payload_offsets.push_back(outputs[0]->payloads.size());
+      payload_sizes.push_back(size);
+
+      auto chunk = std::vector<uint8_t>(static_cast<size_t>(std::min<uint64_t>(size, PAYLOAD_CHUNK)));
+      auto copy = std::vector<uint8_t>(std::size(outputs) > 1 ? std::size(chunk) : 0);
 
-      auto fns = proj->functions();
-      for (auto fn = fns->begin(); fn != fns->end(); ++fn)
+      for (uint64_t offset = 0; offset < size; offset += std::size(chunk))
       {
-        auto symbol = fn->symbol();
-        auto s = symbol->c_str();
-        ss << s << std::endl;
+        auto amount = static_cast<size_t>(std::min<uint64_t>(size - offset, std::size(chunk)));
+        read(chunk.data(), offset, amount);
+
+        // the last output is rebased in place
+        for (size_t i = 0; i != std::size(outputs); ++i)
+        {
+          auto buf = chunk.data();
+          if (i + 1 != std::size(outputs))
+          {
+            std::copy(chunk.data(), chunk.data() + amount, copy.data());
+            buf = copy.data();
+          }
+
+          relocate(i, buf, offset, amount);
+          if (!outputs[i]->payloads.append(buf, amount))
+          {
+            return false;
+          }
+        }
       }
-      return ss.str();
+
+      return true;
     }
 
-    inline void reserve_segments(size_t amount)
+    // NOTE: the first `size` bytes of the segment are not embedded; they are
+    // found in the input file at `offset`; only the remainder is stored in
+    // the segment's bytes
+    inline void set_segment_file_range(Id<Segment> id, uint64_t offset, uint64_t size)
+    {
+      file_range_segments.push_back(id.value());
+      file_range_offsets.push_back(offset);
+      file_range_sizes.push_back(size);
+    }
+
+    // NOTE: patches are applied in order over file-backed ranges
+    inline void add_segment_patch(uint64_t address, uint8_t value)
+    {
+      for (size_t i = 0; i != std::size(outputs); ++i)
+      {
+        add_segment_patch(i, address, value);
+      }
+    }
+
+    inline void add_segment_patch(size_t index, uint64_t address, uint8_t value)
     {
-      segments.resize(amount);
+      auto &output = *outputs[index];
+      output.patch_addresses.push_back(output.rebased(address));
+      output.patch_bytes.push_back(value);
     }
 
-    inline uint8_t *reserve_segment_bytes(size_t amount) {
-      uint8_t *ptr = nullptr;
-      segment_bytes = message.CreateUninitializedVector<uint8_t>(amount, &ptr);
-      return ptr;
+    // NOTE: records the bytes of `word` that differ from `original` (all if
+    // nullptr)
+    inline void add_segment_word_patches(size_t index, uint64_t address, const uint8_t *word, const uint8_t *original, size_t size)
+    {
+      for (size_t i = 0; i < size; ++i)
+      {
+        if (original == nullptr || original[i] != word[i])
+        {
+          add_segment_patch(index, address + i, word[i]);
+        }
+      }
     }
 
     inline void set_segment(
         Id<Segment> id,
         const std::string &name,
         uint64_t address,
-        uint32_t size,
+        uint64_t size,
         uint32_t address_size,
         uint32_t alignment,
         uint32_t bits,
@@ -357,111 +756,787 @@ namespace fugue
         bool writable,
         bool executable)
     {
-      auto name_str = message.CreateString(name);
-      segments[id.index()] = fugue::schema::CreateSegment(
-          message,
-          name_str,
-          address,
-          size,
-          address_size,
-          alignment,
-          bits,
-          endian,
-          code,
-          data,
-          external,
-          readable,
-          writable,
-          executable,
-          segment_bytes);
+      add_large_size(LARGE_SIZE_SEGMENT, id.value(), size);
+      for (auto &output : outputs)
+      {
+        output->sink->set_segment(
+            id,
+            name,
+            output->rebased(address),
+            size,
+            address_size,
+            alignment,
+            bits,
+            endian,
+            code,
+            data,
+            external,
+            readable,
+            writable,
+            executable);
+      }
+    }
+
+    // NOTE: records the IDA function and segment numbers of each exported
+    // function and segment when only part of the database is exported
+    inline void set_selection(const std::vector<uint32_t> &function_numbers, const std::vector<uint32_t> &segment_numbers)
+    {
+      selected_functions = function_numbers;
+      selected_segments = segment_numbers;
     }
 
-    template<typename F> inline size_t vector_aux(const char *name, F f)
+    // NOTE: records a code reference between exported function `fid` and the
+    // excluded function with IDA function number `external`, made from
+    // `address`; `incoming` if the excluded function is the referrer
+    inline void add_external_ref(Id<Function> fid, uint64_t address, uint32_t external, bool incoming)
     {
-      return project_aux.Vector(name, f);
+      external_ref_functions.push_back(fid.value());
+      external_ref_addresses.push_back(address);
+      external_ref_externals.push_back(external);
+      external_ref_incoming.push_back(incoming ? 1 : 0);
     }
 
-    inline size_t string_aux(const char *s)
+    // NOTE: records the IDA function number of the next exported function and
+    // the IDA block number of each of its blocks, in exported order; called in
+    // function id order when the export is laid out for locality
+    inline void add_function_layout(uint32_t function_number, const std::vector<uint32_t> &block_numbers)
     {
-      return project_aux.String(s);
+      layout_functions.push_back(function_number);
+      layout_block_offsets.push_back(static_cast<uint32_t>(std::size(layout_blocks)));
+      layout_blocks.insert(std::end(layout_blocks), std::begin(block_numbers), std::end(block_numbers));
     }
 
-    inline void uint64_aux(uint64_t v)
+    // NOTE: `size` is in bytes within the image, `width` in bytes per unit
+    inline void add_string(uint64_t address, uint32_t size, uint32_t type, uint8_t width, const std::string &contents)
     {
-      project_aux.UInt(v);
+      auto [offset, length] = string_pool.intern(contents);
+      strings.push_back(StringEntry{address, size, type, offset, length, width});
+    }
+
+    inline uint32_t add_import_module(const std::string &name)
+    {
+      auto [offset, length] = import_module_pool.intern(name);
+      import_module_offsets.push_back(offset);
+      import_module_lengths.push_back(length);
+      return static_cast<uint32_t>(std::size(import_module_offsets) - 1);
+    }
+
+    // NOTE: `slot` is the address of the IAT/GOT entry resolved by the loader
+    inline void add_import(uint32_t module, uint64_t slot, const std::string &name, uint64_t ordinal)
+    {
+      auto [offset, length] = import_pool.intern(name);
+      imports.push_back(LinkageEntry{slot, ordinal, module, offset, length});
+    }
+
+    inline void add_export(uint64_t address, const std::string &name, uint64_t ordinal)
+    {
+      auto [offset, length] = export_pool.intern(name);
+      exports.push_back(LinkageEntry{address, ordinal, 0, offset, length});
+    }
+
+    // NOTE: `f` is called once, within every output's names
+    template<typename F> inline void names(F f)
+    {
+      names_from(0, f);
+    }
+
+    inline void set_name(const std::string &name, uint64_t address)
+    {
+      for (auto &output : outputs)
+      {
+        output->sink->set_name(name, output->rebased(address));
+      }
     }
 
   private:
-    inline void build_arches()
+    struct Output
+    {
+      Output(int64_t rebase_delta) : rebase_delta{rebase_delta}
+      {
+        sink.emplace();
+      }
+
+      inline uint64_t rebased(uint64_t address) const
+      {
+        return address + static_cast<uint64_t>(rebase_delta);
+      }
+
+      inline std::vector<uint64_t> rebased(const std::vector<uint64_t> &addresses) const
+      {
+        auto result = addresses;
+        for (auto &address : result)
+        {
+          address = rebased(address);
+        }
+        return result;
+      }
+
+      // virtual rebase applied to all emitted addresses
+      int64_t rebase_delta;
+      std::optional<Sink> sink;
+
+      // out-of-line segment contents, and patches over file-backed ranges
+      SegmentPayloads payloads;
+      std::vector<uint64_t> patch_addresses;
+      std::vector<uint8_t> patch_bytes;
+    };
+
+    template <typename F>
+    inline void names_from(size_t index, F &f)
+    {
+      if (index == std::size(outputs))
+      {
+        f();
+        return;
+      }
+
+      outputs[index]->sink->names([&] {
+        names_from(index + 1, f);
+      });
+    }
+
+    inline auto &function_info(Id<Function> id)
+    {
+      if (std::size(function_infos) <= id.index())
+      {
+        function_infos.resize(id.index() + 1);
+      }
+      return function_infos[id.index()];
+    }
+
+    inline void add_large_size(LargeSizeKind kind, uint64_t id, uint64_t size)
+    {
+      if (size > std::numeric_limits<uint32_t>::max())
+      {
+        large_size_kinds.push_back(kind);
+        large_size_ids.push_back(id);
+        large_size_sizes.push_back(size);
+      }
+    }
+
+    inline void build_arches(Output &output)
     {
-      architectures.resize(std::size(arches));
       for (auto &[arch, id] : arches)
       {
-        auto processor = message.CreateString(arch.processor);
-        auto variant = message.CreateString(arch.variant);
+        output.sink->set_architecture(id.value(), arch.processor, arch.variant, arch.is_be, arch.bits);
+      }
+    }
 
-        architectures[id.index()] = fugue::schema::CreateArchitecture(
-            message,
-            processor,
-            arch.is_be,
-            arch.bits,
-            variant
-        );
+    inline void build_file_ranges(Output &output)
+    {
+      auto &sink = *output.sink;
+
+      if (file_range_segments.empty())
+      {
+        return;
       }
+
+      sink.aux_table("file_ranges", [&] {
+        sink.aux_column("segment", file_range_segments);
+        sink.aux_column("offset", file_range_offsets);
+        sink.aux_column("size", file_range_sizes);
+      });
+
+      sink.aux_table("patches", [&] {
+        sink.aux_column("address", output.patch_addresses);
+        sink.aux_blob("bytes", output.patch_bytes);
+      });
     }
 
-    inline void build_project()
+    // NOTE: `thunk_final` follows chains of thunks to the first exported
+    // function that is not one; it is absent for chains that leave the
+    // export or loop
+    inline void build_function_flags(Output &output)
     {
-      auto archv = message.CreateVector(architectures);
-      auto segsv = message.CreateVector(segments);
-      auto funsv = message.CreateVector(functions);
+      auto &sink = *output.sink;
+
+      if (function_infos.empty())
+      {
+        return;
+      }
 
-      project_aux.EndMap(project_aux_off);
+      auto flags = std::vector<uint8_t>();
+      auto thunk_targets = std::vector<uint64_t>();
+      auto thunk_functions = std::vector<uint32_t>();
+      auto thunk_finals = std::vector<uint32_t>();
 
-      auto aux_buf = project_aux.GetBuffer();
-      uint8_t *aux_ptr = nullptr;
+      flags.reserve(std::size(function_infos));
+      thunk_targets.reserve(std::size(function_infos));
+      thunk_functions.reserve(std::size(function_infos));
+      thunk_finals.reserve(std::size(function_infos));
 
-      auto aux = message.CreateUninitializedVector<uint8_t>(std::size(aux_buf), &aux_ptr);
-      std::copy(std::begin(aux_buf), std::end(aux_buf), aux_ptr);
+      const auto none = std::numeric_limits<uint32_t>::max();
+      const auto no_target = std::numeric_limits<uint64_t>::max();
 
-      project = fugue::schema::CreateProject(
-          message,
-          archv,
-          segsv,
-          funsv,
-          metadata,
-          aux
-      );
-      fugue::schema::FinishProjectBuffer(message, project);
+      for (auto const &info : function_infos)
+      {
+        flags.push_back(info.flags);
+        thunk_targets.push_back(info.thunk_target == no_target ? no_target : output.rebased(info.thunk_target));
+        thunk_functions.push_back(info.thunk_function);
+
+        auto last = none;
+        auto current = info.thunk_function;
+        for (size_t steps = 0; current < std::size(function_infos) && steps != std::size(function_infos); ++steps)
+        {
+          auto const &next = function_infos[current];
+          if (!(next.flags & FUNCTION_THUNK) || next.thunk_function == none)
+          {
+            last = current;
+            break;
+          }
+          current = next.thunk_function;
+        }
+        thunk_finals.push_back(last);
+      }
+
+      sink.aux_table("function_flags", [&] {
+        sink.aux_column("flags", flags);
+        sink.aux_column("thunk_target", thunk_targets);
+        sink.aux_column("thunk_function", thunk_functions);
+        sink.aux_column("thunk_final", thunk_finals);
+      });
+
+      if (!signature_matches.empty())
+      {
+        sink.aux_table("signatures", [&] {
+          sink.aux_column("name_offset", signature_name_offsets);
+          sink.aux_column("name_length", signature_name_lengths);
+          sink.aux_column("title_offset", signature_title_offsets);
+          sink.aux_column("title_length", signature_title_lengths);
+          sink.aux_column("matches", signature_matches);
+          sink.aux_blob("names", signature_pool.bytes());
+        });
+      }
     }
 
-    std::map<Architecture, Id<Architecture>> arches;
-    flatbuffers::FlatBufferBuilder message;
+    // NOTE: out-of-line contents follow any file-backed prefix of their
+    // segment, and are rebased as they are written
+    inline void build_segment_payloads(Output &output)
+    {
+      auto &sink = *output.sink;
+
+      if (payload_segments.empty())
+      {
+        return;
+      }
 
-    size_t project_aux_off;
-    flexbuffers::Builder project_aux;
+      sink.aux_table("segment_payloads", [&] {
+        sink.aux_column("segment", payload_segments);
+        sink.aux_column("offset", payload_offsets);
+        sink.aux_column("size", payload_sizes);
+      });
+    }
 
-    // architectures
-    std::vector<flatbuffers::Offset<fugue::schema::Architecture>> architectures;
+    // NOTE: ids are segment or block ids, and zero for the input's size
+    inline void build_large_sizes(Output &output)
+    {
+      auto &sink = *output.sink;
 
-    // metadata
-    flatbuffers::Offset<fugue::schema::Metadata> metadata;
+      if (large_size_kinds.empty())
+      {
+        return;
+      }
 
-    // functions
-    std::vector<flatbuffers::Offset<fugue::schema::Function>> functions;
-    std::vector<flatbuffers::Offset<fugue::schema::BasicBlock>> function_blocks;
-    std::vector<flatbuffers::Offset<fugue::schema::InterRef>> function_refs;
+      sink.aux_table("large_sizes", [&] {
+        sink.aux_column("kind", large_size_kinds);
+        sink.aux_column("id", large_size_ids);
+        sink.aux_column("size", large_size_sizes);
+      });
+    }
+
+    // NOTE: shared blocks appear once per owning function; ordered by start
+    inline void build_block_index(Output &output)
+    {
+      auto &sink = *output.sink;
+
+      auto starts = std::vector<uint64_t>();
+      auto ends = std::vector<uint64_t>();
+      auto max_ends = std::vector<uint64_t>();
+      auto blocks = std::vector<uint64_t>();
+      auto block_functions = std::vector<uint32_t>();
+
+      starts.reserve(std::size(block_index));
+      max_ends.reserve(std::size(block_index));
+      ends.reserve(std::size(block_index));
+      blocks.reserve(std::size(block_index));
+      block_functions.reserve(std::size(block_index));
+
+      for (auto const &entry : block_index)
+      {
+        starts.push_back(output.rebased(entry.start));
+        ends.push_back(output.rebased(entry.end));
+        max_ends.push_back(max_ends.empty() ? ends.back() : std::max(max_ends.back(), ends.back()));
+        blocks.push_back(entry.block);
+        block_functions.push_back(static_cast<uint32_t>(entry.block >> 32ULL));
+      }
+
+      sink.aux_table("block_index", [&] {
+        sink.aux_column("start", starts);
+        sink.aux_column("end", ends);
+        sink.aux_column("max_end", max_ends);
+        sink.aux_column("block", blocks);
+        sink.aux_column("function", block_functions);
+      });
+    }
+
+    // NOTE: entries are ordered by value, then address and block; when
+    // delta-encoded, each chunk of CONSTANT_CHUNK entries starts at
+    // `chunk_offset` within `entries` and holds, per entry, its kind as a
+    // byte followed by LEB128 varints of its value less the previous value,
+    // the zigzag-encoded difference of its address from the previous
+    // address, and its block's function id and block index; previous values
+    // are zero at the start of each chunk
+    inline void build_constants(Output &output)
+    {
+      auto &sink = *output.sink;
+
+      if (constants.empty())
+      {
+        return;
+      }
+
+      if (!constant_deltas)
+      {
+        auto values = std::vector<uint64_t>();
+        auto addresses = std::vector<uint64_t>();
+        auto blocks = std::vector<uint64_t>();
+        auto kinds = std::vector<uint8_t>();
+
+        values.reserve(std::size(constants));
+        addresses.reserve(std::size(constants));
+        blocks.reserve(std::size(constants));
+        kinds.reserve(std::size(constants));
+
+        for (auto const &entry : constants)
+        {
+          values.push_back(entry.value);
+          addresses.push_back(output.rebased(entry.address));
+          blocks.push_back(entry.block);
+          kinds.push_back(entry.kind);
+        }
+
+        sink.aux_table("constants", [&] {
+          sink.aux_column("value", values);
+          sink.aux_column("address", addresses);
+          sink.aux_column("block", blocks);
+          sink.aux_column("kind", kinds);
+        });
+
+        return;
+      }
+
+      auto chunk_values = std::vector<uint64_t>();
+      auto chunk_offsets = std::vector<uint64_t>();
+      auto entries = std::vector<uint8_t>();
+
+      uint64_t value = 0;
+      uint64_t address = 0;
+
+      for (size_t i = 0; i != std::size(constants); ++i)
+      {
+        auto const &entry = constants[i];
+        if (i % CONSTANT_CHUNK == 0)
+        {
+          chunk_values.push_back(entry.value);
+          chunk_offsets.push_back(std::size(entries));
+          value = 0;
+          address = 0;
+        }
+
+        auto entry_address = output.rebased(entry.address);
+
+        entries.push_back(entry.kind);
+        append_varint(entries, entry.value - value);
+        append_varint(entries, zigzag(static_cast<int64_t>(entry_address - address)));
+        append_varint(entries, entry.block >> 32ULL);
+        append_varint(entries, entry.block & 0xffffffffULL);
+
+        value = entry.value;
+        address = entry_address;
+      }
+
+      sink.aux_table("constants", [&] {
+        sink.aux_column("chunk_value", chunk_values);
+        sink.aux_column("chunk_offset", chunk_offsets);
+        sink.aux_blob("entries", entries);
+      });
+    }
+
+    inline void build_dominators(Output &output)
+    {
+      auto &sink = *output.sink;
+
+      if (!dominator_result.has_value())
+      {
+        return;
+      }
+
+      auto const &result = *dominator_result;
+
+      sink.aux_table("dominators", [&] {
+        sink.aux_column("idom", result.idom);
+        sink.aux_column("ipdom", result.ipdom);
+        sink.aux_column("loop_header", result.loop_header);
+        sink.aux_column("loop_depth", result.loop_depth);
+      });
+
+      sink.aux_table("dominator_functions", [&] {
+        sink.aux_column("block_offset", flow_graphs.blocks);
+      });
+    }
+
+    // NOTE: edges are taken from all code references between exported
+    // functions, calls and tail jumps alike; references from outside the
+    // export are dropped
+    inline void build_call_graph(Output &output)
+    {
+      auto &sink = *output.sink;
+
+      if (!call_graph_result.has_value())
+      {
+        return;
+      }
+
+      auto const &result = *call_graph_result;
+
+      sink.aux_table("call_graph", [&] {
+        sink.aux_column("scc", result.function_scc);
+      });
+
+      sink.aux_table("sccs", [&] {
+        sink.aux_column("level", result.scc_level);
+        sink.aux_column("function_offset", result.scc_function_offsets);
+      });
+
+      sink.aux_table("scc_functions", [&] {
+        sink.aux_column("function", result.scc_functions);
+      });
+
+      sink.aux_table("scc_levels", [&] {
+        sink.aux_column("scc_offset", result.level_offsets);
+      });
+    }
+
+    inline void build_layout(Output &output)
+    {
+      auto &sink = *output.sink;
+
+      if (layout_functions.empty())
+      {
+        return;
+      }
+
+      sink.aux_table("layout", [&] {
+        sink.aux_column("function", layout_functions);
+        sink.aux_column("block_offset", layout_block_offsets);
+      });
+
+      sink.aux_table("block_layout", [&] {
+        sink.aux_column("block", layout_blocks);
+      });
+    }
+
+    inline void build_selection(Output &output)
+    {
+      auto &sink = *output.sink;
+
+      if (selected_functions.empty() && selected_segments.empty())
+      {
+        return;
+      }
+
+      sink.aux_table("selection", [&] {
+        sink.aux_column("function", selected_functions);
+        sink.aux_column("segment", selected_segments);
+      });
+
+      if (external_ref_functions.empty())
+      {
+        return;
+      }
+
+      sink.aux_table("external_refs", [&] {
+        sink.aux_column("function", external_ref_functions);
+        sink.aux_column("address", output.rebased(external_ref_addresses));
+        sink.aux_column("external", external_ref_externals);
+        sink.aux_column("incoming", external_ref_incoming);
+      });
+    }
+
+    inline void build_strings(Output &output)
+    {
+      auto &sink = *output.sink;
+
+      if (strings.empty())
+      {
+        return;
+      }
+
+      auto addresses = std::vector<uint64_t>();
+      auto sizes = std::vector<uint32_t>();
+      auto types = std::vector<uint32_t>();
+      auto widths = std::vector<uint8_t>();
+      auto offsets = std::vector<uint32_t>();
+      auto lengths = std::vector<uint32_t>();
+
+      for (auto const &entry : strings)
+      {
+        addresses.push_back(output.rebased(entry.address));
+        sizes.push_back(entry.size);
+        types.push_back(entry.type);
+        widths.push_back(entry.width);
+        offsets.push_back(entry.offset);
+        lengths.push_back(entry.length);
+      }
+
+      sink.aux_table("strings", [&] {
+        sink.aux_column("address", addresses);
+        sink.aux_column("size", sizes);
+        sink.aux_column("type", types);
+        sink.aux_column("width", widths);
+        sink.aux_column("offset", offsets);
+        sink.aux_column("length", lengths);
+        sink.aux_blob("contents", string_pool.bytes());
+      });
+    }
+
+    inline void build_linkage(Output &output)
+    {
+      auto &sink = *output.sink;
+
+      if (!import_module_offsets.empty())
+      {
+        sink.aux_table("import_modules", [&] {
+          sink.aux_column("offset", import_module_offsets);
+          sink.aux_column("length", import_module_lengths);
+          sink.aux_blob("names", import_module_pool.bytes());
+        });
+      }
+
+      auto build = [&](const char *table, const std::vector<LinkageEntry> &entries, const StringPool &pool, bool with_module) {
+        if (entries.empty())
+        {
+          return;
+        }
+
+        auto addresses = std::vector<uint64_t>();
+        auto ordinals = std::vector<uint64_t>();
+        auto modules = std::vector<uint32_t>();
+        auto offsets = std::vector<uint32_t>();
+        auto lengths = std::vector<uint32_t>();
+
+        for (auto const &entry : entries)
+        {
+          addresses.push_back(output.rebased(entry.address));
+          ordinals.push_back(entry.ordinal);
+          modules.push_back(entry.module);
+          offsets.push_back(entry.offset);
+          lengths.push_back(entry.length);
+        }
+
+        sink.aux_table(table, [&] {
+          sink.aux_column(with_module ? "slot" : "address", addresses);
+          sink.aux_column("ordinal", ordinals);
+          if (with_module)
+          {
+            sink.aux_column("module", modules);
+          }
+          sink.aux_column("offset", offsets);
+          sink.aux_column("length", lengths);
+          sink.aux_blob("names", pool.bytes());
+        });
+      };
+
+      build("imports", imports, import_pool, true);
+      build("exports", exports, export_pool, false);
+    }
+
+    // NOTE: sorts and analyses once for all outputs
+    inline void prepare_project()
+    {
+      if (prepared)
+      {
+        return;
+      }
+      prepared = true;
+
+      if (!function_infos.empty())
+      {
+        function_infos.resize(std::max(std::size(function_infos), functions));
+      }
+
+      if (dominators_enabled && flow_graphs.function_count() != 0)
+      {
+        dominator_result = dominators(flow_graphs, std::thread::hardware_concurrency());
+      }
+
+      if (call_graph_enabled && functions != 0)
+      {
+        call_graph_result = call_graph_sccs(functions, call_edges);
+        call_edges = decltype(call_edges)();
+      }
+
+      std::sort(std::begin(strings), std::end(strings), [](const StringEntry &l, const StringEntry &r) {
+        return l.address < r.address;
+      });
+
+      std::sort(std::begin(constants), std::end(constants), [](const ConstantEntry &l, const ConstantEntry &r) {
+        return l.value < r.value ||
+               (l.value == r.value && (l.address < r.address || (l.address == r.address && l.block < r.block)));
+      });
+
+      auto by_address = [](const LinkageEntry &l, const LinkageEntry &r) {
+        return l.address < r.address || (l.address == r.address && l.ordinal < r.ordinal);
+      };
+      std::sort(std::begin(imports), std::end(imports), by_address);
+      std::sort(std::begin(exports), std::end(exports), by_address);
+
+      std::sort(std::begin(block_index), std::end(block_index), [](const BlockIndexEntry &l, const BlockIndexEntry &r) {
+        return l.start < r.start || (l.start == r.start && l.block < r.block);
+      });
+    }
+
+    inline void build_project(Output &output)
+    {
+      build_selection(output);
+      build_layout(output);
+      build_dominators(output);
+      build_function_flags(output);
+      build_call_graph(output);
+      build_strings(output);
+      build_constants(output);
+      build_linkage(output);
+      build_file_ranges(output);
+      build_segment_payloads(output);
+      build_large_sizes(output);
+      build_block_index(output);
+
+      output.sink->finish();
+    }
+
+    std::map<Architecture, Id<Architecture>> arches;
+    std::vector<std::unique_ptr<Output>> outputs;
+    bool prepared = false;
+
+    size_t functions = 0;
+    size_t segments = 0;
 
     // blocks
-    std::vector<flatbuffers::Offset<fugue::schema::IntraRef>> block_succs;
-    std::vector<flatbuffers::Offset<fugue::schema::IntraRef>> block_preds;
+    struct BlockIndexEntry
+    {
+      uint64_t start;
+      uint64_t end;
+      uint64_t block;
+    };
+
+    std::vector<BlockIndexEntry> block_index;
+
+    // control flow retained for analyses; edges of the function being built
+    // are held until it is set
+    bool dominators_enabled = false;
+    FlowGraphs flow_graphs;
+    std::optional<Dominators> dominator_result;
+    size_t function_block_count = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> function_edges;
+
+    // (caller, callee) pairs of code references between functions
+    bool call_graph_enabled = false;
+    std::vector<std::pair<uint32_t, uint32_t>> call_edges;
+    std::optional<CallGraphSccs> call_graph_result;
+
+    // library, thunk and no-return functions, by function id
+    struct FunctionInfo
+    {
+      uint8_t flags = 0;
+      uint64_t thunk_target = std::numeric_limits<uint64_t>::max();
+      uint32_t thunk_function = std::numeric_limits<uint32_t>::max();
+    };
+
+    std::vector<FunctionInfo> function_infos;
+
+    std::vector<uint32_t> signature_name_offsets;
+    std::vector<uint32_t> signature_name_lengths;
+    std::vector<uint32_t> signature_title_offsets;
+    std::vector<uint32_t> signature_title_lengths;
+    std::vector<uint32_t> signature_matches;
+    StringPool signature_pool;
+
+    // immediate and displacement operands
+    struct ConstantEntry
+    {
+      uint64_t value;
+      uint64_t address;
+      uint64_t block;
+      ConstantKind kind;
+    };
 
-    // segments
-    std::vector<flatbuffers::Offset<fugue::schema::Segment>> segments;
-    flatbuffers::Offset<flatbuffers::Vector<uint8_t>> segment_bytes;
+    bool constant_deltas = false;
+    std::vector<ConstantEntry> constants;
 
-    // project
-    flatbuffers::Offset<fugue::schema::Project> project;
+    // string literals; contents are UTF-8 in a shared pool
+    struct StringEntry
+    {
+      uint64_t address;
+      uint32_t size;
+      uint32_t type;
+      uint32_t offset;
+      uint32_t length;
+      uint8_t width;
+    };
+
+    std::vector<StringEntry> strings;
+    StringPool string_pool;
+
+    // imports and exports (entry points)
+    struct LinkageEntry
+    {
+      uint64_t address;
+      uint64_t ordinal;
+      uint32_t module;
+      uint32_t offset;
+      uint32_t length;
+    };
+
+    std::vector<uint32_t> import_module_offsets;
+    std::vector<uint32_t> import_module_lengths;
+    StringPool import_module_pool;
+
+    std::vector<LinkageEntry> imports;
+    StringPool import_pool;
+
+    std::vector<LinkageEntry> exports;
+    StringPool export_pool;
+
+    // partial exports
+    std::vector<uint32_t> selected_functions;
+    std::vector<uint32_t> selected_segments;
+
+    std::vector<uint32_t> external_ref_functions;
+    std::vector<uint64_t> external_ref_addresses;
+    std::vector<uint32_t> external_ref_externals;
+    std::vector<uint8_t> external_ref_incoming;
+
+    // locality layout; maps exported functions and blocks to IDA's ordering
+    std::vector<uint32_t> layout_functions;
+    std::vector<uint32_t> layout_block_offsets;
+    std::vector<uint32_t> layout_blocks;
+
+    // file-backed segment ranges
+    std::vector<uint32_t> file_range_segments;
+    std::vector<uint64_t> file_range_offsets;
+    std::vector<uint64_t> file_range_sizes;
+
+    // out-of-line segment contents
+    std::vector<uint32_t> payload_segments;
+    std::vector<uint64_t> payload_offsets;
+    std::vector<uint64_t> payload_sizes;
+
+    // sizes exceeding the schema's 32-bit fields
+    std::vector<uint8_t> large_size_kinds;
+    std::vector<uint64_t> large_size_ids;
+    std::vector<uint64_t> large_size_sizes;
   };
 
 }; // namespace fugue
+
+#include <fugue_sink.h>
@@ -0,0 +1,1473 @@
+#pragma once
+
+#include <auto.hpp>
+#include <ida.hpp>
+#include <idp.hpp>
+#include <auto.hpp>
+#include <bytes.hpp>
+#include <entry.hpp>
+#include <fixup.hpp>
+#include <funcs.hpp>
+#include <gdl.hpp>
+#include <kernwin.hpp>
+#include <loader.hpp>
+#include <name.hpp>
+#include <segregs.hpp>
+#include <strlist.hpp>
+#include <ua.hpp>
+#include <xref.hpp>
+
+#include <ldr/pe/pe.h>
+
+#include <deque>
+#include <fstream>
+#include <numeric>
+#include <optional>
+#include <map>
+#include <regex>
+#include <set>
+#include <sstream>
+
+#include <fugue_common.h>
+#include <fugue_ida.h>
+#include <fugue_sink.h>
+#include <ida_helper.h>
+
+namespace fugue
+{
+  namespace ida
+  {
+    template <typename Sink>
+    using ProjectBuilder = ::fugue::ProjectBuilder<fugue::ida::Architecture, Sink>;
+
+    enum class ExportFormat
+    {
+      FDB,
+      Arrow,
+      Raw,
+      Null,
+    };
+
+    enum class ConstantIndex
+    {
+      None,
+      Plain,
+      Delta,
+    };
+
+    // NOTE: filters intersect; an empty filter selects everything
+    struct ExportFilter
+    {
+      std::vector<std::pair<ea_t, ea_t>> ranges;
+      std::optional<std::regex> functions;
+      std::optional<ea_t> reachable_from;
+      std::optional<size_t> reachable_depth;
+
+      inline bool empty() const
+      {
+        return ranges.empty() && !functions.has_value() && !reachable_from.has_value();
+      }
+    };
+
+    // an export's path, and the virtual rebase applied to its addresses
+    struct ExportOutput
+    {
+      std::string path;
+      int64_t rebase = 0;
+    };
+
+    struct ExportOptions
+    {
+      bool file_backed = false;
+      bool strings = false;
+      bool locality = false;
+      bool dominators = false;
+      bool call_graph = false;
+      ConstantIndex constants = ConstantIndex::None;
+      std::optional<bool> large_image;
+      ExportFormat format = ExportFormat::FDB;
+      ExportFilter filter;
+    };
+
+    // maps IDA function and segment numbers to exported ids; ids are dense and
+    // follow IDA's ordering (or the locality layout for functions), and
+    // unselected entities map to an invalid id
+    struct Selection
+    {
+      bool filtered = false;
+
+      std::vector<Id<Function>> functions;
+      std::vector<Id<Segment>> segments;
+
+      std::vector<uint32_t> function_numbers;
+      std::vector<uint32_t> segment_numbers;
+
+      inline Id<Function> function(int fun_num) const
+      {
+        return fun_num < 0 ? Id<Function>() : functions[fun_num];
+      }
+
+      inline bool includes(ea_t ea) const
+      {
+        if (!filtered)
+        {
+          return true;
+        }
+
+        auto seg_num = get_segm_num(ea);
+        return seg_num >= 0 && !(segments[seg_num] == Id<Segment>());
+      }
+    };
+
+    template <typename Sink>
+    void make_architecture(ProjectBuilder<Sink> &builder, ea_t at = BADADDR)
+    {
+      builder.architecture(std::move(Architecture(at)));
+    }
+
+    std::optional<std::string> make_format()
+    {
+      switch (inf_get_filetype())
+      {
+      case f_BIN:
+        return "Raw";
+      case f_PE: {
+        netnode penode(PE_NODE);
+        peheader_t pe;
+
+        penode.valobj(&pe, sizeof(pe));
+
+        if (pe.signature == TEEXE_ID) {
+          return "TE";
+        } else {
+          return "PE";
+        }
+      }
+      case f_ELF:
+        return "ELF";
+      case f_MACHO:
+        return "Mach-O";
+      case f_LOADER:
+        return "Other";
+      default:
+        return std::nullopt;
+      }
+    }
+
+    template <typename Sink>
+    void make_names(ProjectBuilder<Sink> &builder, Selection const &selection)
+    {
+      builder.names([&] {
+        for (auto name_num = 0; name_num != get_nlist_size(); ++name_num)
+        {
+          auto addr = get_nlist_ea(name_num);
+          auto name = get_nlist_name(name_num);
+
+          if (!selection.includes(addr))
+          {
+            continue;
+          }
+
+          builder.set_name(name, addr);
+        }
+      });
+    }
+
+    template <typename Sink>
+    void make_strings(ProjectBuilder<Sink> &builder, Selection const &selection)
+    {
+      // NOTE: the string list is used as-is, and only built if empty
+      if (get_strlist_qty() == 0)
+      {
+        build_strlist();
+      }
+
+      auto contents = qstring();
+      for (size_t str_num = 0; str_num != get_strlist_qty(); ++str_num)
+      {
+        auto info = string_info_t();
+        if (!get_strlist_item(&info, str_num) || !selection.includes(info.ea))
+          continue;
+
+        if (get_strlit_contents(&contents, info.ea, info.length, info.type) < 0)
+          continue;
+
+        builder.add_string(
+            info.ea,
+            info.length,
+            info.type,
+            get_strtype_bpu(info.type),
+            std::string(contents.c_str(), std::size(contents)));
+      }
+    }
+
+    template <typename Sink>
+    void make_signatures(ProjectBuilder<Sink> &builder)
+    {
+      for (auto sig_num = 0; sig_num != get_idasgn_qty(); ++sig_num)
+      {
+        auto name = qstring();
+        auto libs = qstring();
+        auto matches = get_idasgn_desc(&name, &libs, sig_num);
+        if (matches < 0)
+          continue;
+
+        auto title = qstring();
+        get_idasgn_title(&title, name.c_str());
+
+        builder.add_signature(name.c_str(), title.c_str(), static_cast<uint32_t>(matches));
+      }
+    }
+
+    template <typename Sink>
+    struct ImportVisitor
+    {
+      ProjectBuilder<Sink> *builder;
+      uint32_t module;
+    };
+
+    template <typename Sink>
+    int idaapi visit_import(ea_t ea, const char *name, uval_t ordinal, void *ud)
+    {
+      auto visitor = static_cast<ImportVisitor<Sink> *>(ud);
+      visitor->builder->add_import(visitor->module, ea, name != nullptr ? name : "", ordinal);
+      return 1;
+    }
+
+    template <typename Sink>
+    void make_imports(ProjectBuilder<Sink> &builder)
+    {
+      for (auto mod_num = 0; mod_num != get_import_module_qty(); ++mod_num)
+      {
+        auto name = qstring();
+        get_import_module_name(&name, mod_num);
+
+        auto visitor = ImportVisitor<Sink>{&builder, builder.add_import_module(name.c_str())};
+        enum_import_names(mod_num, visit_import<Sink>, &visitor);
+      }
+    }
+
+    template <typename Sink>
+    void make_exports(ProjectBuilder<Sink> &builder)
+    {
+      for (size_t entry_num = 0; entry_num != get_entry_qty(); ++entry_num)
+      {
+        auto ordinal = get_entry_ordinal(entry_num);
+        auto address = get_entry(ordinal);
+        if (address == BADADDR)
+          continue;
+
+        auto name = qstring();
+        get_entry_name(&name, ordinal);
+
+        builder.add_export(address, name.c_str(), ordinal);
+      }
+    }
+
+    // returns the IDA function numbers of the functions called by `function`
+    std::vector<int> callees(func_t *function)
+    {
+      auto targets = std::vector<int>();
+      auto items = func_item_iterator_t(function);
+      for (auto ok = items.first(); ok; ok = items.next_code())
+      {
+        auto xr = xrefblk_t();
+        for (auto okk = xr.first_from(items.current(), XREF_FAR); okk; okk = xr.next_from())
+        {
+          if (!xr.iscode || (xr.type != cref_t::fl_CF && xr.type != cref_t::fl_CN))
+            continue;
+
+          if (auto target = get_func_num(xr.to); target >= 0)
+          {
+            targets.push_back(target);
+          }
+        }
+      }
+      return targets;
+    }
+
+    // records the calls and jumps made by `function` into functions excluded
+    // from the export
+    template <typename Sink>
+    void make_external_refs(ProjectBuilder<Sink> &builder, Selection const &selection, func_t *function, Id<Function> function_id)
+    {
+      auto items = func_item_iterator_t(function);
+      for (auto ok = items.first(); ok; ok = items.next_code())
+      {
+        auto xr = xrefblk_t();
+        for (auto okk = xr.first_from(items.current(), XREF_FAR); okk; okk = xr.next_from())
+        {
+          if (!xr.iscode)
+            continue;
+
+          auto target = get_func(xr.to);
+          if (target == nullptr || target->start_ea != xr.to)
+            continue;
+
+          auto fun_num = get_func_num(xr.to);
+          if (fun_num >= 0 && selection.function(fun_num) == Id<Function>())
+          {
+            builder.add_external_ref(function_id, xr.from, static_cast<uint32_t>(fun_num), false);
+          }
+        }
+      }
+    }
+
+    // returns nothing if the filter's root is not within a function
+    std::optional<Selection> make_selection(ExportFilter const &filter)
+    {
+      auto selection = Selection();
+      selection.filtered = !filter.empty();
+
+      auto fun_qty = get_func_qty();
+      auto seg_qty = get_segm_qty();
+
+      auto in_ranges = [&](ea_t start, ea_t end) {
+        return filter.ranges.empty() || std::any_of(std::begin(filter.ranges), std::end(filter.ranges), [&](auto const &range) {
+          return start < range.second && range.first < end;
+        });
+      };
+
+      auto selected = std::vector<bool>(fun_qty, true);
+
+      if (filter.reachable_from.has_value())
+      {
+        std::fill(std::begin(selected), std::end(selected), false);
+
+        auto root = get_func_num(*filter.reachable_from);
+        if (root < 0)
+        {
+          return std::nullopt;
+        }
+
+        auto depth = filter.reachable_depth.value_or(std::numeric_limits<size_t>::max());
+
+        auto queue = std::deque<std::pair<int, size_t>>();
+        selected[root] = true;
+        queue.emplace_back(root, 0);
+
+        while (!queue.empty())
+        {
+          auto [fun_num, distance] = queue.front();
+          queue.pop_front();
+
+          if (distance == depth)
+          {
+            continue;
+          }
+
+          for (auto callee : callees(getn_func(fun_num)))
+          {
+            if (!selected[callee])
+            {
+              selected[callee] = true;
+              queue.emplace_back(callee, distance + 1);
+            }
+          }
+        }
+      }
+
+      for (auto fun_num = 0; fun_num != fun_qty; ++fun_num)
+      {
+        if (!selected[fun_num])
+        {
+          continue;
+        }
+
+        auto function = getn_func(fun_num);
+        if (!in_ranges(function->start_ea, function->end_ea))
+        {
+          selected[fun_num] = false;
+          continue;
+        }
+
+        if (filter.functions.has_value())
+        {
+          auto name = qstring();
+          get_func_name(&name, function->start_ea);
+          selected[fun_num] = std::regex_search(name.c_str(), *filter.functions);
+        }
+      }
+
+      selection.functions.resize(fun_qty);
+      for (auto fun_num = 0; fun_num != fun_qty; ++fun_num)
+      {
+        if (selected[fun_num])
+        {
+          selection.functions[fun_num] = Id<Function>(std::size(selection.function_numbers));
+          selection.function_numbers.push_back(fun_num);
+        }
+      }
+
+      // NOTE: keep segments overlapping a range or holding a selected function
+      auto segment_used = std::vector<bool>(seg_qty, !selection.filtered);
+      for (auto seg_num = 0; selection.filtered && seg_num != seg_qty; ++seg_num)
+      {
+        auto segment = getnseg(seg_num);
+        segment_used[seg_num] = !filter.ranges.empty() && in_ranges(segment->start_ea, segment->end_ea);
+      }
+
+      for (auto fun_num : selection.function_numbers)
+      {
+        if (auto seg_num = get_segm_num(getn_func(fun_num)->start_ea); seg_num >= 0)
+        {
+          segment_used[seg_num] = true;
+        }
+      }
+
+      selection.segments.resize(seg_qty);
+      for (auto seg_num = 0; seg_num != seg_qty; ++seg_num)
+      {
+        if (segment_used[seg_num])
+        {
+          selection.segments[seg_num] = Id<Segment>(std::size(selection.segment_numbers));
+          selection.segment_numbers.push_back(seg_num);
+        }
+      }
+
+      return selection;
+    }
+
+    // NOTE: lays out the selected functions in depth-first preorder over the
+    // call graph, such that callees tend to follow their callers; traversal
+    // starts from the entry points, then the remaining functions in IDA's
+    // order
+    void make_locality_layout(Selection &selection)
+    {
+      auto roots = std::vector<int>();
+      for (size_t entry_num = 0; entry_num != get_entry_qty(); ++entry_num)
+      {
+        if (auto fun_num = get_func_num(get_entry(get_entry_ordinal(entry_num))); fun_num >= 0)
+        {
+          roots.push_back(fun_num);
+        }
+      }
+      roots.insert(std::end(roots), std::begin(selection.function_numbers), std::end(selection.function_numbers));
+
+      auto visited = std::vector<bool>(std::size(selection.functions), false);
+      auto order = std::vector<uint32_t>();
+      order.reserve(std::size(selection.function_numbers));
+
+      auto stack = std::vector<int>();
+      for (auto root : roots)
+      {
+        if (visited[root] || selection.function(root) == Id<Function>())
+        {
+          continue;
+        }
+
+        stack.push_back(root);
+        while (!stack.empty())
+        {
+          auto fun_num = stack.back();
+          stack.pop_back();
+
+          if (visited[fun_num])
+          {
+            continue;
+          }
+
+          visited[fun_num] = true;
+          order.push_back(fun_num);
+
+          auto targets = callees(getn_func(fun_num));
+          for (auto target = std::rbegin(targets); target != std::rend(targets); ++target)
+          {
+            if (!visited[*target] && !(selection.function(*target) == Id<Function>()))
+            {
+              stack.push_back(*target);
+            }
+          }
+        }
+      }
+
+      selection.function_numbers = std::move(order);
+      for (size_t i = 0; i < std::size(selection.function_numbers); ++i)
+      {
+        selection.functions[selection.function_numbers[i]] = Id<Function>(static_cast<uint32_t>(i));
+      }
+    }
+
+    // returns the blocks of `graph` in reverse postorder from its entry;
+    // blocks unreachable from the entry follow in IDA's order
+    std::vector<int> reverse_postorder(qflow_chart_t const &graph)
+    {
+      auto count = std::size(graph);
+
+      auto order = std::vector<int>();
+      order.reserve(count);
+
+      auto visited = std::vector<bool>(count, false);
+      auto stack = std::vector<std::pair<int, size_t>>();
+
+      if (count != 0)
+      {
+        visited[graph.entry()] = true;
+        stack.emplace_back(graph.entry(), 0);
+      }
+
+      while (!stack.empty())
+      {
+        auto &[block, next] = stack.back();
+        auto const &succs = graph.blocks[block].succ;
+
+        if (next < std::size(succs))
+        {
+          auto succ = succs[next++];
+          if (!visited[succ])
+          {
+            visited[succ] = true;
+            stack.emplace_back(succ, 0);
+          }
+        }
+        else
+        {
+          order.push_back(block);
+          stack.pop_back();
+        }
+      }
+
+      std::reverse(std::begin(order), std::end(order));
+
+      for (auto block = 0; block != count; ++block)
+      {
+        if (!visited[block])
+        {
+          order.push_back(block);
+        }
+      }
+
+      return order;
+    }
+
+    // records the immediate and displacement operands of each instruction
+    // within `block`
+    template <typename Sink>
+    void make_constants(ProjectBuilder<Sink> &builder, qbasic_block_t const &block, Id<BasicBlock> blk_id)
+    {
+      auto insn = insn_t();
+      for (auto ea = block.start_ea; ea < block.end_ea && ea != BADADDR;)
+      {
+        auto length = decode_insn(&insn, ea);
+        if (length <= 0)
+        {
+          ea = next_head(ea, block.end_ea);
+          continue;
+        }
+
+        for (auto const &op : insn.ops)
+        {
+          if (op.type == o_void)
+            break;
+
+          if (op.type == o_imm)
+            builder.add_constant(op.value, ea, blk_id, CONSTANT_IMMEDIATE);
+          else if (op.type == o_displ)
+            builder.add_constant(op.addr, ea, blk_id, CONSTANT_DISPLACEMENT);
+        }
+
+        ea += length;
+      }
+    }
+
+    template <typename Sink>
+    void make_functions(ProjectBuilder<Sink> &builder, ExportOptions const &options, Selection const &selection)
+    {
+      builder.reserve_functions(std::size(selection.function_numbers));
+      for (auto fun_num : selection.function_numbers)
+      {
+        auto function = getn_func(fun_num);
+        auto function_id = selection.function(fun_num);
+        auto segment_id = get_segm_num(function->start_ea);
+
+        auto name = qstring();
+        get_func_name(&name, function->start_ea);
+
+        auto flags = uint8_t(0);
+        if (function->flags & FUNC_LIB)
+          flags |= FUNCTION_LIBRARY;
+        if (function->flags & FUNC_THUNK)
+          flags |= FUNCTION_THUNK;
+        if (function->flags & FUNC_NORET)
+          flags |= FUNCTION_NORETURN;
+
+        builder.set_function_flags(function_id, flags);
+
+        if (function->flags & FUNC_THUNK)
+        {
+          // NOTE: thunks through a pointer (e.g., an import's slot) have no
+          // target function; the pointer's address is recorded instead
+          auto pointer = BADADDR;
+          if (auto target = calc_thunk_func_target(function, &pointer); target != BADADDR)
+          {
+            auto new_name = qstring();
+            get_func_name(&new_name, target);
+            if (!new_name.empty() && std::size(new_name) <= std::size(name))
+            {
+              name = new_name;
+            }
+
+            auto target_function = get_func(target);
+            builder.set_function_thunk(
+                function_id,
+                target,
+                target_function != nullptr && target_function->start_ea == target ? selection.function(get_func_num(target)) : Id<Function>());
+          }
+          else if (pointer != BADADDR)
+          {
+            builder.set_function_thunk(function_id, pointer, Id<Function>());
+          }
+        }
+
+        auto offset = function->start_ea;
+#if IDA_SDK_VERSION < 750
+        auto fc_options = FC_NOEXT | FC_PREDS;
+#else
+        auto fc_options = FC_NOEXT;
+#endif
+        auto graph = qflow_chart_t(
+            nullptr,
+            function,
+            BADADDR,
+            BADADDR,
+            fc_options);
+
+        // NOTE: `order` lists IDA's block numbers in exported order and `rank`
+        // maps them to exported block ids
+        auto order = std::vector<int>(std::size(graph));
+        if (options.locality)
+        {
+          order = reverse_postorder(graph);
+        }
+        else
+        {
+          std::iota(std::begin(order), std::end(order), 0);
+        }
+
+        auto rank = std::vector<int>(std::size(graph));
+        for (auto blk_num = 0; blk_num != std::size(graph); ++blk_num)
+        {
+          rank[order[blk_num]] = blk_num;
+        }
+
+        auto entry = graph.empty() ? Id<BasicBlock>() : Id<BasicBlock>(function_id, rank[graph.entry()]);
+        auto xr = xrefblk_t();
+        auto ref_count = 0;
+        for (auto ok = xr.first_to(offset, XREF_ALL); ok; ok = xr.next_to())
+        {
+          if (!xr.iscode)
+            continue;
+
+          auto owning_func = get_func(xr.from);
+          if (is_func_tail(owning_func))
+          {
+            auto owning_iter = func_parent_iterator_t(owning_func);
+            for (auto okk = owning_iter.first(); okk; okk = owning_iter.next())
+              ref_count++;
+          }
+          else
+          {
+            ref_count++;
+          }
+        }
+
+        builder.reserve_function_refs(ref_count);
+        builder.reserve_function_blocks(std::size(graph));
+
+        for (auto block_idx = 0; block_idx != std::size(graph); ++block_idx)
+        {
+          auto const &block = graph.blocks[order[block_idx]];
+
+          auto blk_id = Id<BasicBlock>(function_id, block_idx);
+          auto offset = block.start_ea;
+          auto length = block.end_ea - block.start_ea;
+
+          builder.reserve_block_preds(std::size(block.pred));
+          builder.reserve_block_succs(std::size(block.succ));
+
+          size_t idx = 0;
+          for (auto const &pred_id : block.pred)
+          {
+            auto id = Id<BasicBlock>(function_id, rank[pred_id]);
+            builder.set_block_pred(function_id, blk_id, idx++, id);
+          }
+
+          idx = 0;
+          for (auto const &succ_id : block.succ)
+          {
+            auto id = Id<BasicBlock>(function_id, rank[succ_id]);
+            builder.set_block_succ(function_id, blk_id, idx++, id);
+          }
+
+          builder.set_block(
+              blk_id,
+              offset,
+              length,
+              builder.architecture(Architecture(offset)));
+
+          if (options.constants != ConstantIndex::None)
+          {
+            make_constants(builder, block, blk_id);
+          }
+        }
+
+        if (options.locality)
+        {
+          builder.add_function_layout(fun_num, std::vector<uint32_t>(std::begin(order), std::end(order)));
+        }
+
+        size_t ref_id = 0;
+        for (auto ok = xr.first_to(offset, XREF_ALL); ok; ok = xr.next_to())
+        {
+          if (!xr.iscode)
+            continue;
+
+          auto owning_func = get_func(xr.from);
+          if (is_func_tail(owning_func))
+          {
+            auto owning_iter = func_parent_iterator_t(owning_func);
+            for (auto okk = owning_iter.first(); okk; okk = owning_iter.next())
+            {
+              // expand to all parent functions
+              auto parent = owning_iter.parent();
+              auto parent_num = get_func_num(parent);
+              auto id = selection.function(parent_num);
+
+              if (parent_num >= 0 && id == Id<Function>())
+              {
+                builder.add_external_ref(function_id, xr.from, static_cast<uint32_t>(parent_num), true);
+              }
+
+              builder.set_function_ref(
+                  function_id,
+                  ref_id++,
+                  xr.from,
+                  id,
+                  xr.type == cref_t::fl_CF || xr.type == cref_t::fl_CN);
+            }
+            continue;
+          }
+
+          auto owning_num = owning_func == nullptr ? -1 : get_func_num(xr.from);
+          auto owning_id = selection.function(owning_num);
+
+          if (owning_num >= 0 && owning_id == Id<Function>())
+          {
+            builder.add_external_ref(function_id, xr.from, static_cast<uint32_t>(owning_num), true);
+          }
+
+          builder.set_function_ref(
+              function_id,
+              ref_id++,
+              xr.from,
+              owning_id,
+              xr.type == cref_t::fl_CF || xr.type == cref_t::fl_CN);
+        }
+
+        if (selection.filtered)
+        {
+          make_external_refs(builder, selection, function, function_id);
+        }
+
+        builder.set_function(function_id, std::string(name.c_str()), offset, entry);
+      }
+    }
+
+    // reads the input file, to compare file-backed ranges with IDA's view of
+    // them; reads fail if the input is no longer available
+    class InputFile
+    {
+    public:
+      InputFile() : stream(fugue::ida::input_file_path(), std::ios::binary) {}
+
+      inline bool read(uint8_t *buf, size_t size, qoff64_t offset)
+      {
+        if (!stream.is_open() || offset < 0)
+        {
+          return false;
+        }
+
+        stream.clear();
+        stream.seekg(static_cast<std::streamoff>(offset));
+        stream.read(reinterpret_cast<char *>(buf), static_cast<std::streamsize>(size));
+        return static_cast<size_t>(stream.gcount()) == size;
+      }
+
+    private:
+      std::ifstream stream;
+    };
+
+    struct SegmentFixup
+    {
+      ea_t ea;
+      size_t size;
+    };
+
+    // returns the segment's absolute address fixups, in address order
+    inline std::vector<SegmentFixup> make_segment_fixups(segment_t *segment)
+    {
+      auto fixups = std::vector<SegmentFixup>();
+
+      auto ea = segment->start_ea;
+      if (!exists_fixup(ea))
+      {
+        ea = get_next_fixup_ea(ea);
+      }
+
+      for (; ea != BADADDR && ea < segment->end_ea; ea = get_next_fixup_ea(ea))
+      {
+        auto fixup = fixup_data_t();
+        if (!get_fixup(&fixup, ea) || fixup.is_extdef())
+        {
+          continue;
+        }
+
+        size_t size = 0;
+        switch (fixup.get_type())
+        {
+        case FIXUP_OFF16:
+        case FIXUP_OFF16S:
+          size = 2;
+          break;
+        case FIXUP_OFF32:
+        case FIXUP_OFF32S:
+          size = 4;
+          break;
+        case FIXUP_OFF64:
+          size = 8;
+          break;
+        default:
+          // NOTE: segment, partial (hi/lo) and custom fixups are left as-is
+          continue;
+        }
+
+        if (ea + size > segment->end_ea)
+        {
+          continue;
+        }
+
+        fixups.push_back(SegmentFixup{ea, size});
+      }
+
+      return fixups;
+    }
+
+    // rebases the words relocated within `content`, which holds the bytes of
+    // the segment from `start` to `end`, for the output at `index`
+    template <typename Sink>
+    void make_segment_relocations(
+        ProjectBuilder<Sink> &builder,
+        size_t index,
+        std::vector<SegmentFixup> const &fixups,
+        uint8_t *content,
+        ea_t start,
+        ea_t end)
+    {
+      if (!builder.is_rebased(index))
+      {
+        return;
+      }
+
+      // NOTE: words of up to 8 bytes starting before `start` may overlap it
+      auto first = std::lower_bound(std::begin(fixups), std::end(fixups), start - std::min<ea_t>(start, 7), [](SegmentFixup const &fixup, ea_t ea) {
+        return fixup.ea < ea;
+      });
+
+      for (auto it = first; it != std::end(fixups) && it->ea < end; ++it)
+      {
+        auto [ea, size] = *it;
+        if (ea + size <= start)
+        {
+          continue;
+        }
+
+        if (ea >= start && ea + size <= end)
+        {
+          builder.rebase_word(index, content + (ea - start), size, inf_is_be());
+          continue;
+        }
+
+        uint8_t word[8] = {0};
+        get_bytes(word, size, ea, GMB_READALL);
+        builder.rebase_word(index, word, size, inf_is_be());
+
+        for (auto i = std::max<ea_t>(ea, start); i < std::min<ea_t>(ea + size, end); ++i)
+        {
+          content[i - start] = word[i - ea];
+        }
+      }
+    }
+
+    // NOTE: records the bytes of relocated words within the file-backed
+    // prefix of the segment, ending at `file_end`, that differ from the input
+    // file (rebased or not), as the loader's fixups are applied to IDA's
+    // bytes but not to the file
+    template <typename Sink>
+    void make_segment_file_relocations(
+        ProjectBuilder<Sink> &builder,
+        InputFile &input,
+        std::vector<SegmentFixup> const &fixups,
+        ea_t file_end)
+    {
+      for (auto [ea, size] : fixups)
+      {
+        if (ea >= file_end)
+        {
+          break;
+        }
+
+        uint8_t word[8] = {0};
+        get_bytes(word, size, ea, GMB_READALL);
+
+        auto backed = static_cast<size_t>(std::min<ea_t>(size, file_end - ea));
+
+        uint8_t original[8] = {0};
+        auto known = input.read(original, backed, get_fileregion_offset(ea));
+
+        for (size_t i = 0; i != builder.output_count(); ++i)
+        {
+          uint8_t rebased[8] = {0};
+          std::copy(word, word + size, rebased);
+          if (builder.is_rebased(i))
+          {
+            builder.rebase_word(i, rebased, size, inf_is_be());
+          }
+
+          builder.add_segment_word_patches(i, ea, rebased, known ? original : nullptr, backed);
+        }
+      }
+    }
+
+    template <typename Sink>
+    int idaapi visit_segment_patch(ea_t ea, qoff64_t, uint64, uint64 value, void *ud)
+    {
+      static_cast<ProjectBuilder<Sink> *>(ud)->add_segment_patch(ea, static_cast<uint8_t>(value));
+      return 0;
+    }
+
+    // returns the length of the prefix of the segment that is mapped
+    // linearly from the input file and records it in the builder
+    template <typename Sink>
+    ea_t make_segment_file_range(ProjectBuilder<Sink> &builder, Id<Segment> id, segment_t *segment)
+    {
+      auto start = segment->start_ea;
+      auto end = segment->end_ea;
+
+      auto base = get_fileregion_offset(start);
+      if (base < 0)
+      {
+        return 0;
+      }
+
+      auto maps = [&](ea_t ea) {
+        return is_loaded(ea) && get_fileregion_offset(ea) == base + static_cast<qoff64_t>(ea - start);
+      };
+
+      // NOTE: file regions are linear, so only page ends are checked
+      const ea_t page_size = 0x1000;
+
+      auto ea = start;
+      while (ea < end)
+      {
+        auto next = std::min<ea_t>(ea + page_size, end);
+        if (maps(next - 1))
+        {
+          ea = next;
+          continue;
+        }
+
+        while (ea < next && maps(ea))
+        {
+          ++ea;
+        }
+        break;
+      }
+
+      if (ea == start)
+      {
+        return 0;
+      }
+
+      builder.set_segment_file_range(id, static_cast<uint64_t>(base), ea - start);
+      visit_patched_bytes(start, ea, visit_segment_patch<Sink>, &builder);
+
+      return ea - start;
+    }
+
+    // NOTE: segment contents are stored out of line when they would not fit
+    // within an FDB (limited to 2 GiB), unless overridden
+    const uint64_t LARGE_IMAGE_THRESHOLD = uint64_t(1) << 30;
+
+    inline bool is_large_image(ExportOptions const &options, Selection const &selection)
+    {
+      if (options.large_image.has_value())
+      {
+        return *options.large_image;
+      }
+
+      uint64_t size = 0;
+      for (auto seg_num : selection.segment_numbers)
+      {
+        auto segment = getnseg(seg_num);
+        size += segment->end_ea - segment->start_ea;
+      }
+      return size > LARGE_IMAGE_THRESHOLD;
+    }
+
+    // returns false if out-of-line contents could not be written
+    template <typename Sink>
+    bool make_segments(ProjectBuilder<Sink> &builder, ExportOptions const &options, Selection const &selection)
+    {
+      auto amount = std::size(selection.segment_numbers);
+      builder.reserve_segments(amount);
+
+      auto input = InputFile();
+
+      for (auto seg_num : selection.segment_numbers)
+      {
+        auto id = selection.segments[seg_num];
+        auto segment = getnseg(seg_num);
+
+        auto name = qstring();
+        get_segm_name(&name, segment);
+
+        auto executable = (SEGPERM_EXEC & segment->perm) != 0;
+        auto readable = (SEGPERM_READ & segment->perm) != 0;
+        auto writable = (SEGPERM_WRITE & segment->perm) != 0;
+
+        auto address_size = segment->abits();
+        auto alignment = 1;
+        switch (segment->align)
+        {
+        case saRelByte:
+          alignment = 1;
+          break;
+        case saRelWord:
+          alignment = 2;
+          break;
+        case saRelDble:
+          alignment = 4;
+          break;
+        case saRelQword:
+          alignment = 8;
+          break;
+        case saRelPara:
+          alignment = 16;
+          break;
+        case saRel32Bytes:
+          alignment = 32;
+          break;
+        case saRel64Bytes:
+          alignment = 64;
+          break;
+        case saRel128Bytes:
+          alignment = 128;
+          break;
+        case saRel512Bytes:
+          alignment = 512;
+          break;
+        case saRel1024Bytes:
+          alignment = 1024;
+          break;
+        case saRel2048Bytes:
+          alignment = 2048;
+          break;
+        default:
+          alignment = 1;
+        }
+
+        auto code = (SEG_CODE & segment->type) != 0;
+        auto data = (SEG_DATA & segment->type) != 0;
+        auto xtrn = (SEG_XTRN & segment->type) != 0;
+
+        auto bits = 16;
+        if (segment->bitness == 2) {
+          bits = 64;
+        } else if (segment->bitness == 1) {
+          bits = 32;
+        }
+
+        auto offset = segment->start_ea;
+        auto length = segment->end_ea - segment->start_ea;
+
+        auto file_length = options.file_backed ? make_segment_file_range(builder, id, segment) : 0;
+        auto embedded_start = offset + file_length;
+        auto embedded_length = length - file_length;
+
+        auto fixups = std::vector<SegmentFixup>();
+        if (builder.is_rebased() || file_length != 0)
+        {
+          fixups = make_segment_fixups(segment);
+        }
+
+        make_segment_file_relocations(builder, input, fixups, embedded_start);
+
+        auto relocate = [&](size_t index, uint8_t *buf, uint64_t from, size_t size) {
+          make_segment_relocations(builder, index, fixups, buf, embedded_start + from, embedded_start + from + size);
+        };
+
+        if (builder.has_segment_payloads())
+        {
+          for (size_t i = 0; i != builder.output_count(); ++i)
+          {
+            builder.reserve_segment_bytes(i, 0);
+          }
+
+          auto read = [&](uint8_t *buf, uint64_t from, size_t size) {
+            get_bytes(buf, size, embedded_start + from, GMB_READALL);
+          };
+
+          if (!builder.add_segment_payload(id, embedded_length, read, relocate))
+          {
+            return false;
+          }
+        }
+        else
+        {
+          // NOTE: read once, then copied to each output before rebasing
+          auto contents = std::vector<uint8_t *>();
+          for (size_t i = 0; i != builder.output_count(); ++i)
+          {
+            contents.push_back(builder.reserve_segment_bytes(i, embedded_length));
+          }
+
+          if (contents[0] != nullptr)
+          {
+            get_bytes(contents[0], embedded_length, embedded_start, GMB_READALL);
+            for (size_t i = 1; i != std::size(contents); ++i)
+            {
+              std::copy(contents[0], contents[0] + embedded_length, contents[i]);
+            }
+
+            for (size_t i = 0; i != std::size(contents); ++i)
+            {
+              relocate(i, contents[i], 0, embedded_length);
+            }
+          }
+        }
+
+        builder.set_segment(
+            id,
+            std::string(name.c_str()),
+            offset,
+            length,
+            address_size,
+            alignment,
+            bits,
+            inf_is_be(), // NOTE: IDA doesn't set byte order on segments
+            code,
+            data,
+            xtrn,
+            readable,
+            writable,
+            executable);
+      }
+
+      return true;
+    }
+
+    // NOTE: extracted once for all outputs
+    template <typename Sink>
+    int import_with(std::vector<ExportOutput> const &outputs, ExportOptions const &options, Selection const &selection)
+    {
+      auto deltas = std::vector<int64_t>();
+      for (auto const &output : outputs)
+      {
+        deltas.push_back(output.rebase);
+      }
+
+      auto builder = ProjectBuilder<Sink>(deltas);
+      builder.set_dominators(options.dominators);
+      builder.set_call_graph(options.call_graph);
+      builder.set_constant_deltas(options.constants == ConstantIndex::Delta);
+
+      auto format = make_format();
+      if (!format.has_value())
+      {
+        msg("Fugue IDB exporter: unsupported format\n");
+        return EXIT_UNSUPPORTED_ERROR;
+      }
+
+      for (size_t i = 0; i != std::size(outputs); ++i)
+      {
+        if (!builder.output(i).open(outputs[i].path))
+        {
+          msg("Fugue IDB exporter: failed to open output\n");
+          return EXIT_IO_ERROR;
+        }
+      }
+
+      auto exporter = "IDA Pro v" + ida_version();
+
+      builder.set_metadata(
+          *format,
+          input_file_path(),
+          input_file_md5(),
+          input_file_sha256(),
+          input_file_size(),
+          exporter);
+
+      if (options.format == ExportFormat::FDB && is_large_image(options, selection))
+      {
+        for (size_t i = 0; i != std::size(outputs); ++i)
+        {
+          if (!builder.set_segment_payloads(i, outputs[i].path + ".segments"))
+          {
+            return EXIT_IO_ERROR;
+          }
+        }
+      }
+
+      make_architecture(builder);
+      if (!make_segments(builder, options, selection))
+      {
+        msg("Fugue IDB exporter: failed to write segment contents\n");
+        return EXIT_IO_ERROR;
+      }
+      make_functions(builder, options, selection);
+      make_signatures(builder);
+      make_names(builder, selection);
+
+      if (options.strings)
+      {
+        make_strings(builder, selection);
+      }
+
+      make_imports(builder);
+      make_exports(builder);
+
+      if (selection.filtered)
+      {
+        builder.set_selection(selection.function_numbers, selection.segment_numbers);
+      }
+
+      for (size_t i = 0; i != std::size(outputs); ++i)
+      {
+        if (!builder.write_to_file(i, outputs[i].path))
+        {
+          msg("Fugue IDB exporter: failed to write database to file\n");
+          return EXIT_IO_ERROR;
+        }
+      }
+
+      auto stats = std::stringstream();
+      stats << "Fugue IDB exporter: successful export:" << std::endl;
+      stats << "- Segments: " << builder.segment_count() << std::endl;
+      stats << "- Functions: " << builder.function_count() << std::endl;
+
+      msg("%s", stats.str().c_str());
+
+      return EXIT_OK;
+    }
+
+    int import(std::vector<ExportOutput> const &outputs, ExportOptions const &options = ExportOptions())
+    {
+      fugue::start_timestamp = current_timestamp();
+
+      auto_wait(); // wait until analysis has finished
+
+      auto selection = make_selection(options.filter);
+      if (!selection.has_value())
+      {
+        msg("Fugue IDB exporter: filter root is not within a function\n");
+        return EXIT_FILTER_ERROR;
+      }
+
+      if (options.locality)
+      {
+        make_locality_layout(*selection);
+      }
+
+      switch (options.format)
+      {
+      case ExportFormat::Arrow:
+        return import_with<ArrowSink>(outputs, options, *selection);
+      case ExportFormat::Raw:
+        return import_with<RawSink>(outputs, options, *selection);
+      case ExportFormat::Null:
+        return import_with<CountingSink>(outputs, options, *selection);
+      default:
+        return import_with<FlatBuffersSink>(outputs, options, *selection);
+      }
+    }
+
+    int import(std::string const &output, ExportOptions const &options = ExportOptions())
+    {
+      return import({ExportOutput{output, 0}}, options);
+    }
+
+    // NOTE: addresses are the database's, before any rebase
+    template <typename Arguments>
+    bool parse_filter(ExportFilter *filter, Arguments &&argument)
+    {
+      for (auto const &range : split_opt(argument("Ranges")))
+      {
+        auto sep = range.find('-', 1);
+        if (sep == std::string::npos)
+        {
+          return false;
+        }
+
+        ea_t start = 0;
+        ea_t end = 0;
+        if (!atoea(&start, range.substr(0, sep).c_str()) || !atoea(&end, range.substr(sep + 1).c_str()) || end <= start)
+        {
+          return false;
+        }
+
+        filter->ranges.emplace_back(start, end);
+      }
+
+      if (auto pattern = argument("Functions"); !pattern.empty())
+      {
+        try
+        {
+          filter->functions = std::regex(pattern);
+        }
+        catch (std::regex_error &)
+        {
+          return false;
+        }
+      }
+
+      if (auto reachable = split_opt(argument("ReachableFrom")); !reachable.empty())
+      {
+        ea_t root = 0;
+        if (std::size(reachable) > 2 || !atoea(&root, reachable[0].c_str()))
+        {
+          return false;
+        }
+        filter->reachable_from = root;
+
+        if (std::size(reachable) == 2)
+        {
+          char *end = nullptr;
+          auto depth = std::strtoull(reachable[1].c_str(), &end, 10);
+          if (reachable[1].empty() || *end != '\0')
+          {
+            return false;
+          }
+          filter->reachable_depth = depth;
+        }
+      }
+
+      return true;
+    }
+
+    bool parse_rebase(std::string const &rebase, int64_t *delta)
+    {
+      auto is_relative = rebase[0] == '+' || rebase[0] == '-';
+      auto value = is_relative ? rebase.substr(1) : rebase;
+
+      ea_t rebase_value = 0;
+      if (!atoea(&rebase_value, value.c_str()))
+      {
+        return false;
+      }
+
+      if (!is_relative)
+      {
+        *delta = static_cast<int64_t>(rebase_value - get_imagebase());
+      }
+      else
+      {
+        *delta = rebase[0] == '-' ? -static_cast<int64_t>(rebase_value) : static_cast<int64_t>(rebase_value);
+      }
+
+      return true;
+    }
+
+    // exports the open database to `Output` (and `Output1`, etc. for further
+    // rebases); `argument` returns option `Fugue<name>`, or "" if unset
+    template <typename Arguments>
+    int export_database(Arguments &&argument)
+    {
+      auto outputs = std::vector<ExportOutput>{ExportOutput{argument("Output"), 0}};
+
+      // NOTE: the n-th base is paired with the n-th output
+      auto rebase = argument("Rebase");
+      if (!rebase.empty())
+      {
+        auto bases = split_opt(rebase);
+        for (size_t i = 1; i < std::size(bases); ++i)
+        {
+          outputs.push_back(ExportOutput{argument(("Output" + std::to_string(i)).c_str()), 0});
+        }
+
+        for (size_t i = 0; i < std::size(bases); ++i)
+        {
+          if (outputs[i].path.empty() || bases[i].empty() || !parse_rebase(bases[i], &outputs[i].rebase))
+          {
+            return EXIT_REBASE_ERROR;
+          }
+        }
+
+        if (!argument(("Output" + std::to_string(std::size(bases))).c_str()).empty())
+        {
+          return EXIT_REBASE_ERROR;
+        }
+      }
+
+      auto force_overwrite = opt_true(argument("ForceOverwrite"));
+      for (auto const &output : outputs)
+      {
+        if (file_exists(output.path.c_str()) && !force_overwrite)
+        {
+          return EXIT_IO_ERROR;
+        }
+      }
+
+      auto options = ExportOptions();
+      options.file_backed = opt_true(argument("FileBacked"));
+      options.strings = opt_true(argument("Strings"));
+      options.locality = opt_true(argument("Locality"));
+      options.dominators = opt_true(argument("Dominators"));
+      options.call_graph = opt_true(argument("CallGraph"));
+
+      if (auto large_image = argument("LargeImage"); !large_image.empty())
+      {
+        options.large_image = opt_true(large_image);
+      }
+
+      auto constants = argument("Constants");
+      if (constants == "plain")
+      {
+        options.constants = ConstantIndex::Plain;
+      }
+      else if (constants == "delta")
+      {
+        options.constants = ConstantIndex::Delta;
+      }
+      else if (!constants.empty() && constants != "none")
+      {
+        return EXIT_UNSUPPORTED_ERROR;
+      }
+
+      auto format = argument("Format");
+      if (format == "arrow")
+      {
+        options.format = ExportFormat::Arrow;
+      }
+      else if (format == "raw")
+      {
+        options.format = ExportFormat::Raw;
+      }
+      else if (format == "null")
+      {
+        options.format = ExportFormat::Null;
+      }
+      else if (!format.empty() && format != "fdb")
+      {
+        return EXIT_UNSUPPORTED_ERROR;
+      }
+
+      if (!parse_filter(&options.filter, argument))
+      {
+        return EXIT_FILTER_ERROR;
+      }
+
+      return import(outputs, options);
+    }
+
+  }; // namespace ida
+};   // namespace fugue
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX 1
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fugue
+{
+
+  // read-only memory mapping of a whole file; pages are faulted in on access
+  class MappedFile
+  {
+  public:
+    MappedFile() = default;
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept
+    {
+      swap(other);
+    }
+
+    MappedFile &operator=(MappedFile &&other) noexcept
+    {
+      if (this != &other)
+      {
+        close();
+        swap(other);
+      }
+      return *this;
+    }
+
+    ~MappedFile()
+    {
+      close();
+    }
+
+    inline bool open(const char *path)
+    {
+      close();
+
+#ifdef _WIN32
+      auto file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (file == INVALID_HANDLE_VALUE)
+      {
+        return false;
+      }
+
+      LARGE_INTEGER file_size;
+      if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+      {
+        CloseHandle(file);
+        return false;
+      }
+
+      auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      CloseHandle(file);
+      if (mapping == nullptr)
+      {
+        return false;
+      }
+
+      auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(mapping);
+      if (view == nullptr)
+      {
+        return false;
+      }
+
+      bytes = static_cast<const uint8_t *>(view);
+      length = static_cast<size_t>(file_size.QuadPart);
+#else
+      auto fd = ::open(path, O_RDONLY);
+      if (fd == -1)
+      {
+        return false;
+      }
+
+      struct stat file_info;
+      if (fstat(fd, &file_info) == -1 || file_info.st_size == 0)
+      {
+        ::close(fd);
+        return false;
+      }
+
+      auto view = mmap(nullptr, static_cast<size_t>(file_info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      ::close(fd);
+      if (view == MAP_FAILED)
+      {
+        return false;
+      }
+
+      bytes = static_cast<const uint8_t *>(view);
+      length = static_cast<size_t>(file_info.st_size);
+#endif
+
+      return true;
+    }
+
+    // NOTE: hints that the mapping will be read front-to-back (or not); the
+    // hint is advisory and ignored where unsupported
+    inline void advise_sequential(bool sequential)
+    {
+#ifndef _WIN32
+      if (bytes != nullptr)
+      {
+        madvise(const_cast<uint8_t *>(bytes), length, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+      }
+#else
+      (void)sequential;
+#endif
+    }
+
+    inline void close()
+    {
+      if (bytes == nullptr)
+      {
+        return;
+      }
+
+#ifdef _WIN32
+      UnmapViewOfFile(bytes);
+#else
+      munmap(const_cast<uint8_t *>(bytes), length);
+#endif
+
+      bytes = nullptr;
+      length = 0;
+    }
+
+    inline const uint8_t *data() const
+    {
+      return bytes;
+    }
+
+    inline size_t size() const
+    {
+      return length;
+    }
+
+    inline bool is_open() const
+    {
+      return bytes != nullptr;
+    }
+
+  private:
+    inline void swap(MappedFile &other)
+    {
+      std::swap(bytes, other.bytes);
+      std::swap(length, other.length);
+    }
+
+    const uint8_t *bytes = nullptr;
+    size_t length = 0;
+  };
+
+}; // namespace fugue
@@ -0,0 +1,934 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <flatbuffers/flexbuffers.h>
+
+#include <fugue_generated.h>
+#include <fugue_mmap.h>
+
+namespace fugue
+{
+
+  // read-only view over a contiguous array, e.g., a segment's bytes within a
+  // mapped FDB
+  template <typename T>
+  struct Span
+  {
+    const T *ptr = nullptr;
+    size_t length = 0;
+
+    inline const T *data() const { return ptr; }
+    inline size_t size() const { return length; }
+    inline bool empty() const { return length == 0; }
+
+    inline const T *begin() const { return ptr; }
+    inline const T *end() const { return ptr + length; }
+
+    inline const T &operator[](size_t index) const { return ptr[index]; }
+  };
+
+  struct BlockRef
+  {
+    uint32_t function;
+    uint32_t block;
+
+    inline uint64_t value() const
+    {
+      return static_cast<uint64_t>(function) << 32ULL | block;
+    }
+
+    static inline BlockRef from(uint64_t id)
+    {
+      return BlockRef{static_cast<uint32_t>(id >> 32ULL), static_cast<uint32_t>(id & 0xffffffffULL)};
+    }
+  };
+
+  // the prefix of a segment referenced from the input file (see
+  // `file_ranges`) rather than stored
+  struct FileRange
+  {
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  // the stored contents of a segment, which start at `address` (following
+  // any file-backed prefix)
+  struct SegmentContents
+  {
+    uint64_t address;
+    Span<uint8_t> bytes;
+  };
+
+  // an instruction operand recorded in the constant index
+  struct Constant
+  {
+    uint64_t value;
+    uint64_t address;
+    BlockRef block;
+    uint8_t kind;
+  };
+
+  // iterates the successors (or predecessors) of a block as BlockRefs
+  class BlockRefs
+  {
+  public:
+    using Refs = flatbuffers::Vector<flatbuffers::Offset<schema::IntraRef>>;
+
+    class iterator
+    {
+    public:
+      iterator(const Refs *refs, flatbuffers::uoffset_t index, bool successors) : refs{refs}, index{index}, successors{successors} {}
+
+      inline BlockRef operator*() const
+      {
+        auto ref = refs->Get(index);
+        return BlockRef::from(successors ? ref->target() : ref->source());
+      }
+
+      inline iterator &operator++()
+      {
+        ++index;
+        return *this;
+      }
+
+      inline bool operator!=(const iterator &other) const
+      {
+        return index != other.index;
+      }
+
+    private:
+      const Refs *refs;
+      flatbuffers::uoffset_t index;
+      bool successors;
+    };
+
+    BlockRefs(const Refs *refs, bool successors) : refs{refs}, successors{successors} {}
+
+    inline iterator begin() const { return iterator(refs, 0, successors); }
+    inline iterator end() const { return iterator(refs, static_cast<flatbuffers::uoffset_t>(size()), successors); }
+    inline size_t size() const { return refs != nullptr ? refs->size() : 0; }
+
+  private:
+    const Refs *refs;
+    bool successors;
+  };
+
+  // memory-mapped FDB reader
+  //
+  // NOTE: only the project table and its vectors are verified on opening;
+  // each function and segment is verified on first access, and the `aux`
+  // map on its first query. Accessors return nullptr (or nothing) for
+  // entities that fail verification. Lookups do not allocate, except for the
+  // name index, which is built on the first lookup by name. A reader may be
+  // shared between threads.
+  class FdbReader
+  {
+  public:
+    FdbReader() = default;
+
+    FdbReader(const FdbReader &) = delete;
+    FdbReader &operator=(const FdbReader &) = delete;
+
+    inline bool open(const char *path)
+    {
+      if (!file.open(path))
+      {
+        return false;
+      }
+
+      if (file.size() < sizeof(flatbuffers::uoffset_t))
+      {
+        return false;
+      }
+
+      auto root = schema::GetProject(file.data());
+      if (!verify_root(root))
+      {
+        return false;
+      }
+
+      project = root;
+
+      // NOTE: contents stored out of line by large-image exports
+      payload_file.open((std::string(path) + ".segments").c_str());
+
+      functions_state.reset(new std::atomic<uint8_t>[function_count()]());
+      segments_state.reset(new std::atomic<uint8_t>[segment_count()]());
+
+      return true;
+    }
+
+    // verifies the whole buffer up front, as consumers otherwise would; all
+    // functions and segments are then known to be valid and are not verified
+    // again on access
+    inline bool verify_all() const
+    {
+      auto verifier = make_verifier();
+      if (!schema::VerifyProjectBuffer(verifier))
+      {
+        return false;
+      }
+
+      for (size_t i = 0; i != function_count(); ++i)
+      {
+        functions_state[i].store(VALID, std::memory_order_release);
+      }
+
+      for (size_t i = 0; i != segment_count(); ++i)
+      {
+        segments_state[i].store(VALID, std::memory_order_release);
+      }
+
+      return true;
+    }
+
+    inline Span<uint8_t> buffer() const
+    {
+      return Span<uint8_t>{file.data(), file.size()};
+    }
+
+    inline const schema::Metadata *metadata() const
+    {
+      auto metadata = project->metadata();
+      auto verifier = make_verifier();
+      return metadata != nullptr && metadata->Verify(verifier) ? metadata : nullptr;
+    }
+
+    inline size_t architecture_count() const
+    {
+      return project->architectures() != nullptr ? project->architectures()->size() : 0;
+    }
+
+    inline const schema::Architecture *architecture(size_t index) const
+    {
+      auto architecture = project->architectures()->Get(static_cast<flatbuffers::uoffset_t>(index));
+      auto verifier = make_verifier();
+      return architecture->Verify(verifier) ? architecture : nullptr;
+    }
+
+    inline size_t function_count() const
+    {
+      return project->functions() != nullptr ? project->functions()->size() : 0;
+    }
+
+    inline const schema::Function *function(size_t index) const
+    {
+      if (index >= function_count())
+      {
+        return nullptr;
+      }
+
+      auto function = project->functions()->Get(static_cast<flatbuffers::uoffset_t>(index));
+      return verified(functions_state[index], function) ? function : nullptr;
+    }
+
+    inline size_t segment_count() const
+    {
+      return project->segments() != nullptr ? project->segments()->size() : 0;
+    }
+
+    inline const schema::Segment *segment(size_t index) const
+    {
+      if (index >= segment_count())
+      {
+        return nullptr;
+      }
+
+      auto segment = project->segments()->Get(static_cast<flatbuffers::uoffset_t>(index));
+      return verified(segments_state[index], segment) ? segment : nullptr;
+    }
+
+    // NOTE: the schema's sizes are 32-bit; larger sizes are recorded in the
+    // `large_sizes` auxiliary table
+    inline uint64_t segment_size(size_t index) const
+    {
+      auto seg = segment(index);
+      if (seg == nullptr)
+      {
+        return 0;
+      }
+
+      if (seg->size() == std::numeric_limits<uint32_t>::max())
+      {
+        auto const &sizes = large_sizes();
+        for (size_t i = 0; sizes.has_value() && i != sizes->ids.size(); ++i)
+        {
+          // NOTE: kind 1 marks a segment's size
+          if (sizes->kinds[i].AsUInt64() == 1 && sizes->ids[i].AsUInt64() == index)
+            return sizes->sizes[i].AsUInt64();
+        }
+      }
+
+      return seg->size();
+    }
+
+    // returns the contents of a segment stored out of line, which follow any
+    // file-backed prefix of the segment (see `file_ranges`); empty if the
+    // segment's contents are embedded or the payload file is missing
+    inline Span<uint8_t> segment_payload(size_t index) const
+    {
+      auto const &payloads = segment_payloads();
+      if (!payloads.has_value() || !payload_file.is_open())
+      {
+        return Span<uint8_t>{};
+      }
+
+      for (size_t i = 0; i != payloads->segments.size(); ++i)
+      {
+        if (payloads->segments[i].AsUInt64() != index)
+        {
+          continue;
+        }
+
+        auto offset = payloads->offsets[i].AsUInt64();
+        auto size = payloads->sizes[i].AsUInt64();
+        if (offset > payload_file.size() || size > payload_file.size() - offset)
+        {
+          break;
+        }
+        return Span<uint8_t>{payload_file.data() + offset, static_cast<size_t>(size)};
+      }
+
+      return Span<uint8_t>{};
+    }
+
+    inline std::optional<FileRange> segment_file_range(size_t index) const
+    {
+      auto const &ranges = file_ranges();
+      for (size_t i = 0; ranges.has_value() && i != ranges->segments.size(); ++i)
+      {
+        if (ranges->segments[i].AsUInt64() == index)
+        {
+          return FileRange{ranges->offsets[i].AsUInt64(), ranges->sizes[i].AsUInt64()};
+        }
+      }
+      return std::nullopt;
+    }
+
+    // resolves a segment's stored contents from its embedded bytes or its
+    // payload; nothing if they are stored out of line but the payload file
+    // is missing or truncated
+    inline std::optional<SegmentContents> segment_contents(size_t index) const
+    {
+      auto seg = segment(index);
+      if (seg == nullptr)
+      {
+        return std::nullopt;
+      }
+
+      auto prefix = segment_file_range(index);
+      auto address = seg->address() + (prefix.has_value() ? prefix->size : 0);
+
+      if (auto const &payloads = segment_payloads(); payloads.has_value())
+      {
+        for (size_t i = 0; i != payloads->segments.size(); ++i)
+        {
+          if (payloads->segments[i].AsUInt64() == index)
+          {
+            auto bytes = segment_payload(index);
+            if (bytes.size() != payloads->sizes[i].AsUInt64())
+            {
+              return std::nullopt;
+            }
+            return SegmentContents{address, bytes};
+          }
+        }
+      }
+
+      return SegmentContents{address, segment_bytes(index)};
+    }
+
+    // calls `f(address, byte)` for each patch over file-backed contents, in
+    // the order they are to be applied; returns the number of patches
+    template <typename F>
+    inline size_t for_each_patch(F f) const
+    {
+      auto table = aux();
+      if (!table.IsMap())
+      {
+        return 0;
+      }
+
+      auto columns = table.AsMap()["patches"];
+      if (!columns.IsMap())
+      {
+        return 0;
+      }
+
+      auto addresses = columns.AsMap()["address"].AsTypedVector();
+      auto bytes = columns.AsMap()["bytes"].AsBlob();
+      if (addresses.size() != bytes.size())
+      {
+        return 0;
+      }
+
+      for (size_t i = 0; i != addresses.size(); ++i)
+      {
+        f(addresses[i].AsUInt64(), bytes.data()[i]);
+      }
+      return addresses.size();
+    }
+
+    // NOTE: empty for file-backed segments, whose contents are referenced
+    // from the input file (see `file_ranges`), and for segments stored out of
+    // line (see segment_payload)
+    inline Span<uint8_t> segment_bytes(size_t index) const
+    {
+      auto seg = segment(index);
+      if (seg == nullptr || seg->bytes() == nullptr)
+      {
+        return Span<uint8_t>{};
+      }
+      return Span<uint8_t>{seg->bytes()->data(), seg->bytes()->size()};
+    }
+
+    inline const schema::BasicBlock *block(BlockRef ref) const
+    {
+      auto fn = function(ref.function);
+      if (fn == nullptr || fn->blocks() == nullptr || ref.block >= fn->blocks()->size())
+      {
+        return nullptr;
+      }
+      return fn->blocks()->Get(ref.block);
+    }
+
+    inline BlockRefs successors(const schema::BasicBlock *block) const
+    {
+      return BlockRefs(block != nullptr ? block->successors() : nullptr, true);
+    }
+
+    inline BlockRefs predecessors(const schema::BasicBlock *block) const
+    {
+      return BlockRefs(block != nullptr ? block->predecessors() : nullptr, false);
+    }
+
+    // finds the block containing `address` using the exported block index;
+    // where blocks overlap, the one starting nearest below `address` is
+    // returned
+    //
+    // NOTE: blocks starting earlier may contain `address` beyond shorter
+    // blocks starting between them, so entries are scanned back until the
+    // running maximum end (`max_end`) no longer covers `address`; indices
+    // without it are scanned back to their start
+    inline std::optional<BlockRef> block_at(uint64_t address) const
+    {
+      auto const &index = block_index();
+      if (!index.has_value())
+      {
+        return std::nullopt;
+      }
+
+      // first entry starting after `address`
+      size_t low = 0;
+      size_t high = index->starts.size();
+      while (low < high)
+      {
+        auto mid = low + (high - low) / 2;
+        if (index->starts[mid].AsUInt64() <= address)
+          low = mid + 1;
+        else
+          high = mid;
+      }
+
+      if (low == 0)
+      {
+        return std::nullopt;
+      }
+
+      for (auto entry = low; entry != 0; --entry)
+      {
+        if (index->bounded && index->max_ends[entry - 1].AsUInt64() <= address)
+        {
+          break;
+        }
+
+        if (address < index->ends[entry - 1].AsUInt64())
+        {
+          return BlockRef::from(index->blocks[entry - 1].AsUInt64());
+        }
+      }
+
+      return std::nullopt;
+    }
+
+    inline std::optional<uint32_t> function_at(uint64_t address) const
+    {
+      if (auto block = block_at(address); block.has_value())
+      {
+        return block->function;
+      }
+      return std::nullopt;
+    }
+
+    // NOTE: if several functions share a name, any one of them is returned
+    inline std::optional<uint32_t> function_by_name(std::string_view name) const
+    {
+      std::call_once(names_once, [this] {
+        auto count = static_cast<uint32_t>(function_count());
+        for (uint32_t i = 0; i != count; ++i)
+        {
+          if (auto fn = function(i); fn != nullptr && fn->symbol() != nullptr)
+            names.push_back(i);
+        }
+
+        std::sort(std::begin(names), std::end(names), [this](uint32_t l, uint32_t r) {
+          return symbol(l) < symbol(r);
+        });
+      });
+
+      auto found = std::lower_bound(std::begin(names), std::end(names), name, [this](uint32_t fn, std::string_view name) {
+        return symbol(fn) < name;
+      });
+
+      if (found == std::end(names) || symbol(*found) != name)
+      {
+        return std::nullopt;
+      }
+      return *found;
+    }
+
+    // calls `f(constant)` for each operand in the constant index whose value
+    // is `value`, in address order; returns the number found
+    template <typename F>
+    inline size_t for_each_constant(uint64_t value, F f) const
+    {
+      auto const &index = constant_index();
+      if (!index.has_value())
+      {
+        return 0;
+      }
+
+      size_t found = 0;
+
+      if (!index->delta)
+      {
+        auto entry = lower_bound(index->values, value);
+        for (; entry < index->values.size() && index->values[entry].AsUInt64() == value; ++entry)
+        {
+          f(Constant{
+              value,
+              index->addresses[entry].AsUInt64(),
+              BlockRef::from(index->blocks[entry].AsUInt64()),
+              static_cast<uint8_t>(index->kinds[entry].AsUInt64())});
+          ++found;
+        }
+        return found;
+      }
+
+      // entries equal to `value` may begin in the chunk before the first
+      // whose initial value is `value`
+      auto chunk = lower_bound(index->chunk_values, value);
+      if (chunk != 0)
+      {
+        --chunk;
+      }
+
+      auto entries = index->entries.data();
+      auto entries_end = entries + index->entries.size();
+
+      for (; chunk < index->chunk_values.size(); ++chunk)
+      {
+        auto offset = index->chunk_offsets[chunk].AsUInt64();
+        auto end = chunk + 1 < index->chunk_offsets.size() ? index->chunk_offsets[chunk + 1].AsUInt64() : index->entries.size();
+        if (offset > end || end > index->entries.size())
+        {
+          return found;
+        }
+
+        auto current = Constant{0, 0, BlockRef{0, 0}, 0};
+        for (auto ptr = entries + offset; ptr < entries + end;)
+        {
+          uint64_t value_delta, address_delta, function, block;
+          current.kind = *ptr++;
+          if (!read_varint(ptr, entries_end, value_delta) ||
+              !read_varint(ptr, entries_end, address_delta) ||
+              !read_varint(ptr, entries_end, function) ||
+              !read_varint(ptr, entries_end, block))
+          {
+            return found;
+          }
+
+          current.value += value_delta;
+          current.address += (address_delta >> 1) ^ (~(address_delta & 1) + 1);
+          current.block = BlockRef{static_cast<uint32_t>(function), static_cast<uint32_t>(block)};
+
+          if (current.value > value)
+          {
+            return found;
+          }
+
+          if (current.value == value)
+          {
+            f(current);
+            ++found;
+          }
+        }
+      }
+
+      return found;
+    }
+
+    // returns the root of the `aux` map, or a null reference if the map is
+    // absent or malformed
+    inline flexbuffers::Reference aux() const
+    {
+      std::call_once(aux_once, [this] {
+        auto bytes = project->aux();
+        aux_valid = bytes != nullptr && bytes->size() != 0 && flexbuffers::VerifyBuffer(bytes->data(), bytes->size());
+      });
+
+      if (!aux_valid)
+      {
+        return flexbuffers::Reference();
+      }
+      return flexbuffers::GetRoot(project->aux()->data(), project->aux()->size());
+    }
+
+  private:
+    struct BlockIndex
+    {
+      flexbuffers::TypedVector starts;
+      flexbuffers::TypedVector ends;
+      flexbuffers::TypedVector blocks;
+
+      bool bounded;
+      flexbuffers::TypedVector max_ends;
+    };
+
+    struct FileRanges
+    {
+      flexbuffers::TypedVector segments;
+      flexbuffers::TypedVector offsets;
+      flexbuffers::TypedVector sizes;
+    };
+
+    struct SegmentPayloads
+    {
+      flexbuffers::TypedVector segments;
+      flexbuffers::TypedVector offsets;
+      flexbuffers::TypedVector sizes;
+    };
+
+    struct LargeSizes
+    {
+      flexbuffers::TypedVector kinds;
+      flexbuffers::TypedVector ids;
+      flexbuffers::TypedVector sizes;
+    };
+
+    struct ConstantIndex
+    {
+      bool delta;
+
+      flexbuffers::TypedVector values = flexbuffers::TypedVector::EmptyTypedVector();
+      flexbuffers::TypedVector addresses = flexbuffers::TypedVector::EmptyTypedVector();
+      flexbuffers::TypedVector blocks = flexbuffers::TypedVector::EmptyTypedVector();
+      flexbuffers::TypedVector kinds = flexbuffers::TypedVector::EmptyTypedVector();
+
+      flexbuffers::TypedVector chunk_values = flexbuffers::TypedVector::EmptyTypedVector();
+      flexbuffers::TypedVector chunk_offsets = flexbuffers::TypedVector::EmptyTypedVector();
+      flexbuffers::Blob entries = flexbuffers::Blob::EmptyBlob();
+    };
+
+    enum : uint8_t
+    {
+      UNVERIFIED = 0,
+      VALID = 1,
+      INVALID = 2,
+    };
+
+    // NOTE: exports hold a table per block and edge, so the default table
+    // limit is far too low for large projects
+    inline flatbuffers::Verifier make_verifier() const
+    {
+      return flatbuffers::Verifier(file.data(), file.size(), 64, std::numeric_limits<flatbuffers::uoffset_t>::max());
+    }
+
+    // NOTE: checks the project table and the vectors it holds, but none of
+    // the tables those vectors refer to
+    inline bool verify_root(const schema::Project *root) const
+    {
+      auto verifier = make_verifier();
+      auto table = reinterpret_cast<const uint8_t *>(root);
+      if (!verifier.VerifyTableStart(table))
+      {
+        return false;
+      }
+
+      // fields are read from the table's inline part, which is not covered
+      // by VerifyTableStart
+      auto vtable = table - flatbuffers::ReadScalar<flatbuffers::soffset_t>(table);
+      if (flatbuffers::ReadScalar<flatbuffers::voffset_t>(vtable) < 2 * sizeof(flatbuffers::voffset_t))
+      {
+        return false;
+      }
+      auto size = flatbuffers::ReadScalar<flatbuffers::voffset_t>(vtable + sizeof(flatbuffers::voffset_t));
+
+      return verifier.Verify(table, size) &&
+             verifier.VerifyVector(root->architectures()) &&
+             verifier.VerifyVector(root->segments()) &&
+             verifier.VerifyVector(root->functions()) &&
+             verifier.VerifyVector(root->aux());
+    }
+
+    // NOTE: concurrent first accesses may verify an entity more than once
+    template <typename T>
+    inline bool verified(std::atomic<uint8_t> &state, const T *table) const
+    {
+      auto current = state.load(std::memory_order_acquire);
+      if (current == UNVERIFIED)
+      {
+        auto verifier = make_verifier();
+        current = table->Verify(verifier) ? VALID : INVALID;
+        state.store(current, std::memory_order_release);
+      }
+      return current == VALID;
+    }
+
+    inline std::string_view symbol(uint32_t function) const
+    {
+      auto symbol = project->functions()->Get(function)->symbol();
+      return std::string_view(symbol->c_str(), symbol->size());
+    }
+
+    // first entry of `values` not less than `value`
+    static inline size_t lower_bound(flexbuffers::TypedVector const &values, uint64_t value)
+    {
+      size_t low = 0;
+      size_t high = values.size();
+      while (low < high)
+      {
+        auto mid = low + (high - low) / 2;
+        if (values[mid].AsUInt64() < value)
+          low = mid + 1;
+        else
+          high = mid;
+      }
+      return low;
+    }
+
+    static inline bool read_varint(const uint8_t *&ptr, const uint8_t *end, uint64_t &value)
+    {
+      value = 0;
+      for (unsigned shift = 0; ptr < end && shift < 64; shift += 7)
+      {
+        auto byte = *ptr++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    inline std::optional<FileRanges> const &file_ranges() const
+    {
+      std::call_once(file_ranges_once, [this] {
+        auto table = aux();
+        if (!table.IsMap())
+        {
+          return;
+        }
+
+        auto columns = table.AsMap()["file_ranges"];
+        if (!columns.IsMap())
+        {
+          return;
+        }
+
+        auto map = columns.AsMap();
+        auto segments = map["segment"].AsTypedVector();
+        auto offsets = map["offset"].AsTypedVector();
+        auto sizes = map["size"].AsTypedVector();
+
+        if (segments.size() == offsets.size() && segments.size() == sizes.size())
+        {
+          file_range_index.emplace(FileRanges{segments, offsets, sizes});
+        }
+      });
+
+      return file_range_index;
+    }
+
+    inline std::optional<SegmentPayloads> const &segment_payloads() const
+    {
+      std::call_once(payloads_once, [this] {
+        auto table = aux();
+        if (!table.IsMap())
+        {
+          return;
+        }
+
+        auto columns = table.AsMap()["segment_payloads"];
+        if (!columns.IsMap())
+        {
+          return;
+        }
+
+        auto map = columns.AsMap();
+        auto segments = map["segment"].AsTypedVector();
+        auto offsets = map["offset"].AsTypedVector();
+        auto sizes = map["size"].AsTypedVector();
+
+        if (segments.size() == offsets.size() && segments.size() == sizes.size())
+        {
+          payload_index.emplace(SegmentPayloads{segments, offsets, sizes});
+        }
+      });
+
+      return payload_index;
+    }
+
+    inline std::optional<LargeSizes> const &large_sizes() const
+    {
+      std::call_once(large_sizes_once, [this] {
+        auto table = aux();
+        if (!table.IsMap())
+        {
+          return;
+        }
+
+        auto columns = table.AsMap()["large_sizes"];
+        if (!columns.IsMap())
+        {
+          return;
+        }
+
+        auto map = columns.AsMap();
+        auto kinds = map["kind"].AsTypedVector();
+        auto ids = map["id"].AsTypedVector();
+        auto sizes = map["size"].AsTypedVector();
+
+        if (kinds.size() == ids.size() && kinds.size() == sizes.size())
+        {
+          large_size_index.emplace(LargeSizes{kinds, ids, sizes});
+        }
+      });
+
+      return large_size_index;
+    }
+
+    inline std::optional<ConstantIndex> const &constant_index() const
+    {
+      std::call_once(constant_index_once, [this] {
+        auto table = aux();
+        if (!table.IsMap())
+        {
+          return;
+        }
+
+        auto columns = table.AsMap()["constants"];
+        if (!columns.IsMap())
+        {
+          return;
+        }
+
+        auto map = columns.AsMap();
+        auto index = ConstantIndex{};
+
+        if (map["entries"].IsBlob())
+        {
+          index.delta = true;
+          index.chunk_values = map["chunk_value"].AsTypedVector();
+          index.chunk_offsets = map["chunk_offset"].AsTypedVector();
+          index.entries = map["entries"].AsBlob();
+
+          if (index.chunk_values.size() != index.chunk_offsets.size())
+          {
+            return;
+          }
+        }
+        else
+        {
+          index.delta = false;
+          index.values = map["value"].AsTypedVector();
+          index.addresses = map["address"].AsTypedVector();
+          index.blocks = map["block"].AsTypedVector();
+          index.kinds = map["kind"].AsTypedVector();
+
+          if (index.values.size() != index.addresses.size() ||
+              index.values.size() != index.blocks.size() ||
+              index.values.size() != index.kinds.size())
+          {
+            return;
+          }
+        }
+
+        constants.emplace(index);
+      });
+
+      return constants;
+    }
+
+    inline std::optional<BlockIndex> const &block_index() const
+    {
+      std::call_once(block_index_once, [this] {
+        auto table = aux();
+        if (!table.IsMap())
+        {
+          return;
+        }
+
+        auto columns = table.AsMap()["block_index"];
+        if (!columns.IsMap())
+        {
+          return;
+        }
+
+        auto map = columns.AsMap();
+        auto starts = map["start"].AsTypedVector();
+        auto ends = map["end"].AsTypedVector();
+        auto blocks = map["block"].AsTypedVector();
+        auto max_ends = map["max_end"].AsTypedVector();
+
+        if (starts.size() == ends.size() && starts.size() == blocks.size())
+        {
+          auto bounded = max_ends.size() == starts.size();
+          blocks_by_address.emplace(BlockIndex{starts, ends, blocks, bounded, max_ends});
+        }
+      });
+
+      return blocks_by_address;
+    }
+
+    MappedFile file;
+    MappedFile payload_file;
+    const schema::Project *project = nullptr;
+
+    std::unique_ptr<std::atomic<uint8_t>[]> functions_state;
+    std::unique_ptr<std::atomic<uint8_t>[]> segments_state;
+
+    mutable std::once_flag aux_once;
+    mutable bool aux_valid = false;
+
+    mutable std::once_flag block_index_once;
+    mutable std::optional<BlockIndex> blocks_by_address;
+
+    mutable std::once_flag file_ranges_once;
+    mutable std::optional<FileRanges> file_range_index;
+
+    mutable std::once_flag payloads_once;
+    mutable std::optional<SegmentPayloads> payload_index;
+
+    mutable std::once_flag large_sizes_once;
+    mutable std::optional<LargeSizes> large_size_index;
+
+    mutable std::once_flag constant_index_once;
+    mutable std::optional<ConstantIndex> constants;
+
+    mutable std::once_flag names_once;
+    mutable std::vector<uint32_t> names;
+  };
+
+}; // namespace fugue
@@ -0,0 +1,1146 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fugue_generated.h>
+
+#include <fugue_arrow.h>
+#include <fugue_common.h>
+
+// Output sinks for ProjectBuilder.
+//
+// A sink is a compile-time policy: ProjectBuilder forwards every entity it
+// is given (with addresses already rebased) to its sink by static dispatch.
+// Each sink provides:
+//
+// - open (before anything else is given to the sink)
+// - set_metadata, set_architecture
+// - reserve_functions, reserve_function_blocks, reserve_function_refs,
+//   set_function, set_function_ref
+// - reserve_block_preds, reserve_block_succs, set_block, set_block_pred,
+//   set_block_succ
+// - reserve_segments, reserve_segment_bytes (nullptr if contents are
+//   discarded), set_segment
+// - names, set_name
+// - aux_table, aux_column, aux_blob
+// - finish, write
+
+namespace fugue
+{
+
+  class FlatBuffersSink
+  {
+  public:
+    FlatBuffersSink() : message{1024}, project_aux{1024}
+    {
+      project_aux_off = project_aux.StartMap();
+    }
+
+    inline bool open(const std::string &)
+    {
+      return true;
+    }
+
+    inline void set_metadata(
+        const std::string &input_format,
+        const std::string &input_path,
+        const std::vector<uint8_t> &input_md5,
+        const std::vector<uint8_t> &input_sha256,
+        uint64_t input_size,
+        const std::string &exporter)
+    {
+      metadata = fugue::schema::CreateMetadataDirect(
+          message,
+          input_format.c_str(),
+          input_path.c_str(),
+          &input_md5,
+          &input_sha256,
+          saturate32(input_size),
+          exporter.c_str()
+      );
+    }
+
+    inline void set_architecture(uint32_t id, const std::string &processor, const std::string &variant, bool is_be, uint32_t bits)
+    {
+      if (std::size(architectures) <= id)
+      {
+        architectures.resize(id + 1);
+      }
+
+      architectures[id] = fugue::schema::CreateArchitecture(
+          message,
+          message.CreateString(processor),
+          is_be,
+          bits,
+          message.CreateString(variant)
+      );
+    }
+
+    inline void reserve_functions(size_t amount)
+    {
+      functions.resize(amount);
+    }
+
+    inline void reserve_function_blocks(size_t amount)
+    {
+      function_blocks.clear();
+      function_blocks.resize(amount);
+    }
+
+    inline void reserve_function_refs(size_t amount)
+    {
+      function_refs.clear();
+      function_refs.resize(amount);
+    }
+
+    inline void set_function(Id<Function> id, const std::string &symbol, uint64_t address, Id<BasicBlock> entry)
+    {
+      auto symbol_str = message.CreateString(symbol);
+      auto fblocks = message.CreateVector(function_blocks.data(), std::size(function_blocks));
+      auto frefs = message.CreateVector(function_refs.data(), std::size(function_refs));
+
+      functions[id.index()] = fugue::schema::CreateFunction(
+          message,
+          symbol_str,
+          address,
+          entry.value(),
+          fblocks,
+          frefs
+      );
+    }
+
+    inline void reserve_block_succs(size_t amount)
+    {
+      block_succs = std::vector<flatbuffers::Offset<fugue::schema::IntraRef>>(amount);
+    }
+
+    inline void reserve_block_preds(size_t amount)
+    {
+      block_preds = std::vector<flatbuffers::Offset<fugue::schema::IntraRef>>(amount);
+    }
+
+    inline void set_block(Id<BasicBlock> bid, uint64_t address, uint64_t size, uint32_t arch)
+    {
+      auto bpreds = message.CreateVector(block_preds.data(), std::size(block_preds));
+      auto bsuccs = message.CreateVector(block_succs.data(), std::size(block_succs));
+
+      function_blocks[bid.index()] = fugue::schema::CreateBasicBlock(
+          message,
+          address,
+          saturate32(size),
+          arch,
+          bpreds,
+          bsuccs
+      );
+    }
+
+    inline void set_function_ref(Id<Function> fid, size_t index, uint64_t address, Id<Function> source, bool call)
+    {
+      function_refs[index] = fugue::schema::CreateInterRefDirect(
+          message,
+          address,
+          source.value(),
+          fid.value(),
+          call
+      );
+    }
+
+    inline void set_block_pred(Id<Function> fid, Id<BasicBlock> bid, size_t index, Id<BasicBlock> source)
+    {
+      block_preds[index] = fugue::schema::CreateIntraRefDirect(
+          message,
+          source.value(),
+          bid.value(),
+          fid.value()
+      );
+    }
+
+    inline void set_block_succ(Id<Function> fid, Id<BasicBlock> bid, size_t index, Id<BasicBlock> target)
+    {
+      block_succs[index] = fugue::schema::CreateIntraRefDirect(
+          message,
+          bid.value(),
+          target.value(),
+          fid.value()
+      );
+    }
+
+    inline void reserve_segments(size_t amount)
+    {
+      segments.resize(amount);
+    }
+
+    inline uint8_t *reserve_segment_bytes(size_t amount)
+    {
+      uint8_t *ptr = nullptr;
+      segment_bytes = message.CreateUninitializedVector<uint8_t>(amount, &ptr);
+      return ptr;
+    }
+
+    inline void set_segment(
+        Id<Segment> id,
+        const std::string &name,
+        uint64_t address,
+        uint64_t size,
+        uint32_t address_size,
+        uint32_t alignment,
+        uint32_t bits,
+        bool endian,
+        bool code,
+        bool data,
+        bool external,
+        bool readable,
+        bool writable,
+        bool executable)
+    {
+      auto name_str = message.CreateString(name);
+      segments[id.index()] = fugue::schema::CreateSegment(
+          message,
+          name_str,
+          address,
+          saturate32(size),
+          address_size,
+          alignment,
+          bits,
+          endian,
+          code,
+          data,
+          external,
+          readable,
+          writable,
+          executable,
+          segment_bytes);
+    }
+
+    template <typename F> inline void names(F f)
+    {
+      project_aux.Vector("names", f);
+    }
+
+    inline void set_name(const std::string &name, uint64_t address)
+    {
+      project_aux.String(name);
+      project_aux.UInt(address);
+    }
+
+    template <typename F> inline void aux_table(const char *name, F f)
+    {
+      project_aux.Map(name, f);
+    }
+
+    template <typename T> inline void aux_column(const char *name, const std::vector<T> &v)
+    {
+      project_aux.Vector(name, v.data(), std::size(v));
+    }
+
+    inline void aux_blob(const char *name, const std::vector<uint8_t> &v)
+    {
+      project_aux.Blob(name, v.data(), std::size(v));
+    }
+
+    inline void finish()
+    {
+      auto archv = message.CreateVector(architectures);
+      auto segsv = message.CreateVector(segments);
+      auto funsv = message.CreateVector(functions);
+
+      project_aux.EndMap(project_aux_off);
+      project_aux.Finish();
+
+      auto aux_buf = project_aux.GetBuffer();
+      uint8_t *aux_ptr = nullptr;
+
+      auto aux = message.CreateUninitializedVector<uint8_t>(std::size(aux_buf), &aux_ptr);
+      std::copy(std::begin(aux_buf), std::end(aux_buf), aux_ptr);
+
+      project = fugue::schema::CreateProject(
+          message,
+          archv,
+          segsv,
+          funsv,
+          metadata,
+          aux
+      );
+      fugue::schema::FinishProjectBuffer(message, project);
+    }
+
+    inline bool write(const std::string &path)
+    {
+      return write_buffer_to_file(path, message.GetBufferPointer(), message.GetSize());
+    }
+
+    inline std::string function_names()
+    {
+      auto ss = std::stringstream();
+      auto *proj = fugue::schema::GetProject(message.GetBufferPointer());
+
+      auto fns = proj->functions();
+      for (auto fn = fns->begin(); fn != fns->end(); ++fn)
+      {
+        auto symbol = fn->symbol();
+        auto s = symbol->c_str();
+        ss << s << std::endl;
+      }
+      return ss.str();
+    }
+
+  private:
+    flatbuffers::FlatBufferBuilder message;
+
+    size_t project_aux_off;
+    flexbuffers::Builder project_aux;
+
+    // architectures
+    std::vector<flatbuffers::Offset<fugue::schema::Architecture>> architectures;
+
+    // metadata
+    flatbuffers::Offset<fugue::schema::Metadata> metadata;
+
+    // functions
+    std::vector<flatbuffers::Offset<fugue::schema::Function>> functions;
+    std::vector<flatbuffers::Offset<fugue::schema::BasicBlock>> function_blocks;
+    std::vector<flatbuffers::Offset<fugue::schema::InterRef>> function_refs;
+
+    // blocks
+    std::vector<flatbuffers::Offset<fugue::schema::IntraRef>> block_succs;
+    std::vector<flatbuffers::Offset<fugue::schema::IntraRef>> block_preds;
+
+    // segments
+    std::vector<flatbuffers::Offset<fugue::schema::Segment>> segments;
+    flatbuffers::Offset<flatbuffers::Vector<uint8_t>> segment_bytes;
+
+    // project
+    flatbuffers::Offset<fugue::schema::Project> project;
+  };
+
+  // NOTE: writes one Arrow IPC stream per table to `<prefix>.<table>.arrows`;
+  // segment contents are not exported. Auxiliary blobs, and auxiliary columns
+  // whose length differs from their table's first column, are written as
+  // their own single-column tables named `<table>.<column>`
+  class ArrowSink
+  {
+  public:
+    inline bool open(const std::string &)
+    {
+      return true;
+    }
+
+    inline void set_metadata(
+        const std::string &,
+        const std::string &,
+        const std::vector<uint8_t> &,
+        const std::vector<uint8_t> &,
+        uint64_t,
+        const std::string &)
+    {
+    }
+
+    inline void set_architecture(uint32_t id, const std::string &processor, const std::string &variant, bool is_be, uint32_t bits)
+    {
+      architecture_id.push_back(id);
+      architecture_processor.push_back(processor);
+      architecture_variant.push_back(variant);
+      architecture_is_be.push_back(is_be);
+      architecture_bits.push_back(bits);
+    }
+
+    inline void reserve_functions(size_t amount)
+    {
+      function_id.reserve(amount);
+    }
+
+    inline void reserve_function_blocks(size_t amount)
+    {
+      function_block_count = amount;
+    }
+
+    inline void reserve_function_refs(size_t amount)
+    {
+      function_ref_count = amount;
+    }
+
+    inline void set_function(Id<Function> id, const std::string &symbol, uint64_t address, Id<BasicBlock> entry)
+    {
+      function_id.push_back(id.value());
+      function_address.push_back(address);
+      function_entry.push_back(entry.value());
+      function_symbol.push_back(symbol);
+      function_blocks.push_back(static_cast<uint32_t>(function_block_count));
+      function_refs.push_back(static_cast<uint32_t>(function_ref_count));
+    }
+
+    inline void reserve_block_succs(size_t amount)
+    {
+      block_succ_count = amount;
+    }
+
+    inline void reserve_block_preds(size_t amount)
+    {
+      block_pred_count = amount;
+    }
+
+    inline void set_block(Id<BasicBlock> bid, uint64_t address, uint64_t size, uint32_t arch)
+    {
+      block_id.push_back(bid.value());
+      block_function.push_back(static_cast<uint32_t>(bid.value() >> 32ULL));
+      block_address.push_back(address);
+      block_size.push_back(size);
+      block_architecture.push_back(arch);
+      block_preds.push_back(static_cast<uint32_t>(block_pred_count));
+      block_succs.push_back(static_cast<uint32_t>(block_succ_count));
+    }
+
+    inline void set_function_ref(Id<Function> fid, size_t, uint64_t address, Id<Function> source, bool call)
+    {
+      ref_address.push_back(address);
+      ref_source.push_back(source.value());
+      ref_target.push_back(fid.value());
+      ref_call.push_back(call);
+    }
+
+    inline void set_block_pred(Id<Function>, Id<BasicBlock>, size_t, Id<BasicBlock>)
+    {
+    }
+
+    inline void set_block_succ(Id<Function> fid, Id<BasicBlock> bid, size_t, Id<BasicBlock> target)
+    {
+      edge_function.push_back(fid.value());
+      edge_source.push_back(bid.value());
+      edge_target.push_back(target.value());
+    }
+
+    inline void reserve_segments(size_t amount)
+    {
+      segment_id.reserve(amount);
+    }
+
+    inline uint8_t *reserve_segment_bytes(size_t)
+    {
+      return nullptr;
+    }
+
+    inline void set_segment(
+        Id<Segment> id,
+        const std::string &name,
+        uint64_t address,
+        uint64_t size,
+        uint32_t,
+        uint32_t,
+        uint32_t bits,
+        bool,
+        bool code,
+        bool data,
+        bool external,
+        bool readable,
+        bool writable,
+        bool executable)
+    {
+      segment_id.push_back(id.value());
+      segment_name.push_back(name);
+      segment_address.push_back(address);
+      segment_size.push_back(size);
+      segment_bits.push_back(bits);
+      segment_flags.push_back(static_cast<uint8_t>(
+          code << 0 | data << 1 | external << 2 | readable << 3 | writable << 4 | executable << 5));
+    }
+
+    template <typename F> inline void names(F f)
+    {
+      f();
+    }
+
+    inline void set_name(const std::string &name, uint64_t address)
+    {
+      name_address.push_back(address);
+      name_symbol.push_back(name);
+    }
+
+    template <typename F> inline void aux_table(const char *name, F f)
+    {
+      aux_name = name;
+      aux_tables.emplace_back(aux_name, arrow::Table());
+      f();
+    }
+
+    template <typename T> inline void aux_column(const char *name, const std::vector<T> &v)
+    {
+      auto &table = aux_tables[aux_index(name, std::size(v))].second;
+      table.column(name, v);
+    }
+
+    inline void aux_blob(const char *name, const std::vector<uint8_t> &v)
+    {
+      aux_tables.emplace_back(aux_name + "." + name, arrow::Table());
+      aux_tables.back().second.column(name, v);
+    }
+
+    inline void finish()
+    {
+      auto architectures = arrow::Table();
+      architectures.column("id", architecture_id);
+      architectures.column("processor", architecture_processor);
+      architectures.column("variant", architecture_variant);
+      architectures.column("is_be", architecture_is_be);
+      architectures.column("bits", architecture_bits);
+
+      auto functions = arrow::Table();
+      functions.column("id", function_id);
+      functions.column("address", function_address);
+      functions.column("entry", function_entry);
+      functions.column("symbol", function_symbol);
+      functions.column("blocks", function_blocks);
+      functions.column("refs", function_refs);
+
+      auto blocks = arrow::Table();
+      blocks.column("id", block_id);
+      blocks.column("function", block_function);
+      blocks.column("address", block_address);
+      blocks.column("size", block_size);
+      blocks.column("architecture", block_architecture);
+      blocks.column("preds", block_preds);
+      blocks.column("succs", block_succs);
+
+      auto edges = arrow::Table();
+      edges.column("function", edge_function);
+      edges.column("source", edge_source);
+      edges.column("target", edge_target);
+
+      auto refs = arrow::Table();
+      refs.column("address", ref_address);
+      refs.column("source", ref_source);
+      refs.column("target", ref_target);
+      refs.column("call", ref_call);
+
+      auto segments = arrow::Table();
+      segments.column("id", segment_id);
+      segments.column("name", segment_name);
+      segments.column("address", segment_address);
+      segments.column("size", segment_size);
+      segments.column("bits", segment_bits);
+      segments.column("flags", segment_flags);
+
+      auto names = arrow::Table();
+      names.column("address", name_address);
+      names.column("name", name_symbol);
+
+      tables.emplace_back("architectures", architectures.finish());
+      tables.emplace_back("functions", functions.finish());
+      tables.emplace_back("blocks", blocks.finish());
+      tables.emplace_back("edges", edges.finish());
+      tables.emplace_back("refs", refs.finish());
+      tables.emplace_back("segments", segments.finish());
+      tables.emplace_back("names", names.finish());
+
+      for (auto const &[name, table] : aux_tables)
+      {
+        tables.emplace_back(name, table.finish());
+      }
+    }
+
+    inline bool write(const std::string &prefix)
+    {
+      for (auto const &[name, stream] : tables)
+      {
+        if (!write_buffer_to_file(prefix + "." + name + ".arrows", stream.data(), std::size(stream)))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+  private:
+    std::vector<uint32_t> architecture_id;
+    std::vector<std::string> architecture_processor;
+    std::vector<std::string> architecture_variant;
+    std::vector<uint8_t> architecture_is_be;
+    std::vector<uint32_t> architecture_bits;
+
+    size_t function_block_count = 0;
+    size_t function_ref_count = 0;
+
+    std::vector<uint32_t> function_id;
+    std::vector<uint64_t> function_address;
+    std::vector<uint64_t> function_entry;
+    std::vector<std::string> function_symbol;
+    std::vector<uint32_t> function_blocks;
+    std::vector<uint32_t> function_refs;
+
+    size_t block_pred_count = 0;
+    size_t block_succ_count = 0;
+
+    std::vector<uint64_t> block_id;
+    std::vector<uint32_t> block_function;
+    std::vector<uint64_t> block_address;
+    std::vector<uint64_t> block_size;
+    std::vector<uint32_t> block_architecture;
+    std::vector<uint32_t> block_preds;
+    std::vector<uint32_t> block_succs;
+
+    std::vector<uint32_t> edge_function;
+    std::vector<uint64_t> edge_source;
+    std::vector<uint64_t> edge_target;
+
+    std::vector<uint64_t> ref_address;
+    std::vector<uint32_t> ref_source;
+    std::vector<uint32_t> ref_target;
+    std::vector<uint8_t> ref_call;
+
+    std::vector<uint32_t> segment_id;
+    std::vector<std::string> segment_name;
+    std::vector<uint64_t> segment_address;
+    std::vector<uint64_t> segment_size;
+    std::vector<uint32_t> segment_bits;
+    std::vector<uint8_t> segment_flags;
+
+    std::vector<uint64_t> name_address;
+    std::vector<std::string> name_symbol;
+
+    inline size_t aux_index(const char *name, size_t length)
+    {
+      for (size_t i = std::size(aux_tables); i-- > 0;)
+      {
+        if (aux_tables[i].first == aux_name && (aux_tables[i].second.empty() || aux_tables[i].second.length() == length))
+        {
+          return i;
+        }
+      }
+
+      aux_tables.emplace_back(aux_name + "." + name, arrow::Table());
+      return std::size(aux_tables) - 1;
+    }
+
+    std::string aux_name;
+    std::vector<std::pair<std::string, arrow::Table>> aux_tables;
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> tables;
+  };
+
+  namespace raw
+  {
+
+    // Raw export layout: a FileHeader followed by records, each a Record
+    // header and `size` bytes of payload padded to 8 bytes. Payloads begin
+    // with the POD below, followed by any strings or bytes it sizes.
+
+    const char MAGIC[8] = {'F', 'U', 'G', 'U', 'E', 'R', 'A', 'W'};
+    const uint32_t VERSION = 2;
+
+    enum RecordKind : uint32_t
+    {
+      METADATA = 1,
+      ARCHITECTURE = 2,
+      SEGMENT_BYTES = 3,
+      SEGMENT = 4,
+      BLOCK_PRED = 5,
+      BLOCK_SUCC = 6,
+      BLOCK = 7,
+      FUNCTION_REF = 8,
+      FUNCTION = 9,
+      NAME = 10,
+      AUX_COLUMN = 11,
+    };
+
+    struct FileHeader
+    {
+      char magic[8];
+      uint32_t version;
+      uint32_t reserved;
+    };
+
+    struct Record
+    {
+      uint32_t kind;
+      uint32_t reserved;
+      uint64_t size;
+    };
+
+    // + format, path, exporter
+    struct Metadata
+    {
+      uint64_t input_size;
+      uint32_t format_size;
+      uint32_t path_size;
+      uint32_t exporter_size;
+      uint32_t reserved;
+      uint8_t md5[16];
+      uint8_t sha256[32];
+    };
+
+    // + processor, variant
+    struct Architecture
+    {
+      uint32_t id;
+      uint32_t bits;
+      uint32_t is_be;
+      uint32_t processor_size;
+      uint32_t variant_size;
+      uint32_t reserved;
+    };
+
+    // + name; contents are the preceding SEGMENT_BYTES record
+    struct Segment
+    {
+      uint64_t address;
+      uint64_t size;
+      uint32_t id;
+      uint32_t name_size;
+      uint32_t address_size;
+      uint32_t alignment;
+      uint32_t bits;
+      uint32_t flags;
+    };
+
+    struct IntraRef
+    {
+      uint64_t source;
+      uint64_t target;
+      uint32_t function;
+      uint32_t reserved;
+    };
+
+    // preceded by its BLOCK_PRED and BLOCK_SUCC records
+    struct Block
+    {
+      uint64_t id;
+      uint64_t address;
+      uint64_t size;
+      uint32_t architecture;
+      uint32_t reserved;
+    };
+
+    struct InterRef
+    {
+      uint64_t address;
+      uint32_t source;
+      uint32_t target;
+      uint32_t call;
+      uint32_t reserved;
+    };
+
+    // + symbol; preceded by its BLOCK and FUNCTION_REF records
+    struct Function
+    {
+      uint64_t address;
+      uint64_t entry;
+      uint32_t id;
+      uint32_t symbol_size;
+    };
+
+    // + name
+    struct Name
+    {
+      uint64_t address;
+      uint32_t name_size;
+      uint32_t reserved;
+    };
+
+    // + table name, column name, count * element_size bytes
+    struct AuxColumn
+    {
+      uint64_t count;
+      uint32_t table_size;
+      uint32_t column_size;
+      uint32_t element_size;
+      uint32_t reserved;
+    };
+
+  }; // namespace raw
+
+  // NOTE: records are streamed to the file given to open, or to the one
+  // given to write if it was not opened; buffered records are written once
+  // they exceed RAW_FLUSH_SIZE
+  const size_t RAW_FLUSH_SIZE = size_t(1) << 20;
+
+  class RawSink
+  {
+  public:
+    RawSink()
+    {
+      auto header = raw::FileHeader{};
+      std::memcpy(header.magic, raw::MAGIC, sizeof(header.magic));
+      header.version = raw::VERSION;
+      append(&header, sizeof(header));
+    }
+
+    RawSink(const RawSink &) = delete;
+    RawSink &operator=(const RawSink &) = delete;
+
+    ~RawSink()
+    {
+      if (fd >= 0)
+      {
+        close_file(fd);
+      }
+    }
+
+    inline bool open(const std::string &path)
+    {
+      fd = open_for_writing(path);
+      return fd >= 0;
+    }
+
+    inline void set_metadata(
+        const std::string &input_format,
+        const std::string &input_path,
+        const std::vector<uint8_t> &input_md5,
+        const std::vector<uint8_t> &input_sha256,
+        uint64_t input_size,
+        const std::string &exporter)
+    {
+      auto record = raw::Metadata{};
+      record.input_size = input_size;
+      record.format_size = static_cast<uint32_t>(std::size(input_format));
+      record.path_size = static_cast<uint32_t>(std::size(input_path));
+      record.exporter_size = static_cast<uint32_t>(std::size(exporter));
+      std::memcpy(record.md5, input_md5.data(), std::min(sizeof(record.md5), std::size(input_md5)));
+      std::memcpy(record.sha256, input_sha256.data(), std::min(sizeof(record.sha256), std::size(input_sha256)));
+
+      auto size = sizeof(record) + record.format_size + record.path_size + record.exporter_size;
+      begin(raw::METADATA, size);
+      append(&record, sizeof(record));
+      append(input_format.data(), record.format_size);
+      append(input_path.data(), record.path_size);
+      append(exporter.data(), record.exporter_size);
+      end(size);
+    }
+
+    inline void set_architecture(uint32_t id, const std::string &processor, const std::string &variant, bool is_be, uint32_t bits)
+    {
+      auto record = raw::Architecture{id, bits, is_be, static_cast<uint32_t>(std::size(processor)), static_cast<uint32_t>(std::size(variant)), 0};
+
+      auto size = sizeof(record) + record.processor_size + record.variant_size;
+      begin(raw::ARCHITECTURE, size);
+      append(&record, sizeof(record));
+      append(processor.data(), record.processor_size);
+      append(variant.data(), record.variant_size);
+      end(size);
+    }
+
+    inline void reserve_functions(size_t) {}
+    inline void reserve_function_blocks(size_t) {}
+    inline void reserve_function_refs(size_t) {}
+
+    inline void set_function(Id<Function> id, const std::string &symbol, uint64_t address, Id<BasicBlock> entry)
+    {
+      auto record = raw::Function{address, entry.value(), id.value(), static_cast<uint32_t>(std::size(symbol))};
+
+      auto size = sizeof(record) + record.symbol_size;
+      begin(raw::FUNCTION, size);
+      append(&record, sizeof(record));
+      append(symbol.data(), record.symbol_size);
+      end(size);
+    }
+
+    inline void reserve_block_succs(size_t) {}
+    inline void reserve_block_preds(size_t) {}
+
+    inline void set_block(Id<BasicBlock> bid, uint64_t address, uint64_t size, uint32_t arch)
+    {
+      put(raw::BLOCK, raw::Block{bid.value(), address, size, arch, 0});
+    }
+
+    inline void set_function_ref(Id<Function> fid, size_t, uint64_t address, Id<Function> source, bool call)
+    {
+      put(raw::FUNCTION_REF, raw::InterRef{address, source.value(), fid.value(), call, 0});
+    }
+
+    inline void set_block_pred(Id<Function> fid, Id<BasicBlock> bid, size_t, Id<BasicBlock> source)
+    {
+      put(raw::BLOCK_PRED, raw::IntraRef{source.value(), bid.value(), fid.value(), 0});
+    }
+
+    inline void set_block_succ(Id<Function> fid, Id<BasicBlock> bid, size_t, Id<BasicBlock> target)
+    {
+      put(raw::BLOCK_SUCC, raw::IntraRef{bid.value(), target.value(), fid.value(), 0});
+    }
+
+    inline void reserve_segments(size_t) {}
+
+    // NOTE: the returned pointer is valid until the next record is written
+    inline uint8_t *reserve_segment_bytes(size_t amount)
+    {
+      begin(raw::SEGMENT_BYTES, amount);
+      auto offset = std::size(buffer);
+      buffer.resize(offset + amount);
+      end(amount);
+      return buffer.data() + offset;
+    }
+
+    inline void set_segment(
+        Id<Segment> id,
+        const std::string &name,
+        uint64_t address,
+        uint64_t size,
+        uint32_t address_size,
+        uint32_t alignment,
+        uint32_t bits,
+        bool endian,
+        bool code,
+        bool data,
+        bool external,
+        bool readable,
+        bool writable,
+        bool executable)
+    {
+      auto flags = static_cast<uint32_t>(
+          code << 0 | data << 1 | external << 2 | readable << 3 | writable << 4 | executable << 5 | endian << 6);
+      auto record = raw::Segment{address, size, id.value(), static_cast<uint32_t>(std::size(name)), address_size, alignment, bits, flags};
+
+      auto record_size = sizeof(record) + record.name_size;
+      begin(raw::SEGMENT, record_size);
+      append(&record, sizeof(record));
+      append(name.data(), record.name_size);
+      end(record_size);
+    }
+
+    template <typename F> inline void names(F f)
+    {
+      f();
+    }
+
+    inline void set_name(const std::string &name, uint64_t address)
+    {
+      auto record = raw::Name{address, static_cast<uint32_t>(std::size(name)), 0};
+
+      auto size = sizeof(record) + record.name_size;
+      begin(raw::NAME, size);
+      append(&record, sizeof(record));
+      append(name.data(), record.name_size);
+      end(size);
+    }
+
+    template <typename F> inline void aux_table(const char *name, F f)
+    {
+      aux_name = name;
+      f();
+    }
+
+    template <typename T> inline void aux_column(const char *name, const std::vector<T> &v)
+    {
+      auto record = raw::AuxColumn{std::size(v), static_cast<uint32_t>(std::size(aux_name)), static_cast<uint32_t>(std::strlen(name)), sizeof(T), 0};
+
+      auto size = sizeof(record) + record.table_size + record.column_size + sizeof(T) * std::size(v);
+      begin(raw::AUX_COLUMN, size);
+      append(&record, sizeof(record));
+      append(aux_name.data(), record.table_size);
+      append(name, record.column_size);
+      append(v.data(), sizeof(T) * std::size(v));
+      end(size);
+    }
+
+    inline void aux_blob(const char *name, const std::vector<uint8_t> &v)
+    {
+      aux_column(name, v);
+    }
+
+    inline void finish() {}
+
+    inline bool write(const std::string &path)
+    {
+      if (fd < 0 && !open(path))
+      {
+        return false;
+      }
+
+      auto success = flush();
+      close_file(fd);
+      fd = -1;
+
+      return success;
+    }
+
+  private:
+    inline void append(const void *data, size_t size)
+    {
+      auto bytes = static_cast<const uint8_t *>(data);
+      buffer.insert(std::end(buffer), bytes, bytes + size);
+    }
+
+    inline bool flush()
+    {
+      failed = failed || !write_all(fd, buffer.data(), std::size(buffer));
+      buffer.clear();
+      return !failed;
+    }
+
+    // NOTE: flushes only between records, as reserve_segment_bytes hands
+    // out a pointer into the buffer
+    inline void begin(raw::RecordKind kind, size_t size)
+    {
+      if (fd >= 0 && std::size(buffer) >= RAW_FLUSH_SIZE)
+      {
+        flush();
+      }
+
+      auto record = raw::Record{kind, 0, size};
+      append(&record, sizeof(record));
+    }
+
+    inline void end(size_t size)
+    {
+      buffer.resize(std::size(buffer) + (8 - size % 8) % 8);
+    }
+
+    template <typename T> inline void put(raw::RecordKind kind, const T &record)
+    {
+      begin(kind, sizeof(T));
+      append(&record, sizeof(T));
+      end(sizeof(T));
+    }
+
+    std::string aux_name;
+    std::vector<uint8_t> buffer;
+
+    int fd = -1;
+    bool failed = false;
+  };
+
+  // NOTE: discards everything it is given, only counting entities; used to
+  // measure extraction cost independent of serialisation
+  class CountingSink
+  {
+  public:
+    inline bool open(const std::string &)
+    {
+      return true;
+    }
+
+    inline void set_metadata(
+        const std::string &,
+        const std::string &,
+        const std::vector<uint8_t> &,
+        const std::vector<uint8_t> &,
+        uint64_t,
+        const std::string &)
+    {
+    }
+
+    inline void set_architecture(uint32_t, const std::string &, const std::string &, bool, uint32_t)
+    {
+      ++architectures;
+    }
+
+    inline void reserve_functions(size_t) {}
+    inline void reserve_function_blocks(size_t) {}
+    inline void reserve_function_refs(size_t) {}
+
+    inline void set_function(Id<Function>, const std::string &, uint64_t, Id<BasicBlock>)
+    {
+      ++functions;
+    }
+
+    inline void reserve_block_succs(size_t) {}
+    inline void reserve_block_preds(size_t) {}
+
+    inline void set_block(Id<BasicBlock>, uint64_t, uint64_t, uint32_t)
+    {
+      ++blocks;
+    }
+
+    inline void set_function_ref(Id<Function>, size_t, uint64_t, Id<Function>, bool)
+    {
+      ++function_refs;
+    }
+
+    inline void set_block_pred(Id<Function>, Id<BasicBlock>, size_t, Id<BasicBlock>)
+    {
+      ++block_edges;
+    }
+
+    inline void set_block_succ(Id<Function>, Id<BasicBlock>, size_t, Id<BasicBlock>)
+    {
+      ++block_edges;
+    }
+
+    inline void reserve_segments(size_t) {}
+
+    inline uint8_t *reserve_segment_bytes(size_t amount)
+    {
+      segment_bytes += amount;
+      return nullptr;
+    }
+
+    inline void set_segment(
+        Id<Segment>,
+        const std::string &,
+        uint64_t,
+        uint64_t,
+        uint32_t,
+        uint32_t,
+        uint32_t,
+        bool,
+        bool,
+        bool,
+        bool,
+        bool,
+        bool,
+        bool)
+    {
+      ++segments;
+    }
+
+    template <typename F> inline void names(F f)
+    {
+      f();
+    }
+
+    inline void set_name(const std::string &, uint64_t)
+    {
+      ++names_;
+    }
+
+    template <typename F> inline void aux_table(const char *, F f)
+    {
+      f();
+    }
+
+    template <typename T> inline void aux_column(const char *, const std::vector<T> &v)
+    {
+      aux_bytes += sizeof(T) * std::size(v);
+    }
+
+    inline void aux_blob(const char *, const std::vector<uint8_t> &v)
+    {
+      aux_bytes += std::size(v);
+    }
+
+    inline void finish() {}
+
+    inline bool write(const std::string &)
+    {
+      auto stats = std::stringstream();
+      stats << "Fugue IDB exporter: counted (not written):" << std::endl;
+      stats << "- Architectures: " << architectures << std::endl;
+      stats << "- Segments: " << segments << " (" << segment_bytes << " bytes)" << std::endl;
+      stats << "- Functions: " << functions << std::endl;
+      stats << "- Blocks: " << blocks << std::endl;
+      stats << "- Block edges: " << block_edges << std::endl;
+      stats << "- Function refs: " << function_refs << std::endl;
+      stats << "- Names: " << names_ << std::endl;
+      stats << "- Auxiliary data: " << aux_bytes << " bytes" << std::endl;
+
+      msg("%s", stats.str().c_str());
+      return true;
+    }
+
+  private:
+    size_t architectures = 0;
+    size_t segments = 0;
+    size_t segment_bytes = 0;
+    size_t functions = 0;
+    size_t blocks = 0;
+    size_t block_edges = 0;
+    size_t function_refs = 0;
+    size_t names_ = 0;
+    size_t aux_bytes = 0;
+  };
+
+}; // namespace fugue
@@ -14,12 +14,16 @@
 //! ```
 
 use std::env;
+use std::fs;
+use std::io::{self, BufRead, Write};
 use std::path::{Path, PathBuf};
 use std::process;
+use std::sync::atomic::{AtomicUsize, Ordering};
 
 use fugue_db::Error as ExportError;
 use fugue_db::backend::{Backend, Imported};
 
+use sha2::{Digest, Sha256};
 use tempfile::tempdir;
 use which::{which, which_in};
 use url::Url;
@@ -42,10 +46,14 @@ pub enum Error {
     Unsupported,
     #[error("IDA Pro reported error when attempting to rebase")]
     Rebase,
+    #[error("IDA Pro reported invalid export filter")]
+    Filter,
     #[error("IDA Pro encountered a generic failure")]
     Failure,
     #[error("could not create temporary directory to store exported database: {0}")]
     TempDirectory(#[source] std::io::Error),
+    #[error("could not access analysed database cache: {0}")]
+    Cache(#[source] std::io::Error),
     #[error("`{0}` is not a supported URL scheme")]
     UnsupportedScheme(String),
 }
@@ -56,11 +64,56 @@ impl From<Error> for ExportError {
     }
 }
 
+/// Virtual rebase applied by the exporter; the analysed database is left
+/// untouched and only the exported addresses (and relocated words within
+/// segment contents) are adjusted.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, PartialOrd, Ord, Hash)]
+pub enum Rebase {
+    /// Rebase such that the image base becomes the given address.
+    Absolute(u64),
+    /// Shift all addresses by the given signed delta.
+    Relative(i64),
+}
+
+impl Rebase {
+    fn to_option(&self) -> String {
+        match *self {
+            Self::Absolute(base) => format!("{:#x}", base),
+            Self::Relative(delta) if delta < 0 => format!("-{:#x}", delta.unsigned_abs()),
+            Self::Relative(delta) => format!("+{:#x}", delta),
+        }
+    }
+}
+
+/// Layout of the index of immediate and displacement operand values.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, PartialOrd, Ord, Hash)]
+pub enum ConstantIndex {
+    /// No index is exported.
+    None,
+    /// Fixed-width columns sorted by value.
+    Plain,
+    /// Delta-encoded chunks, each headed by its first value.
+    Delta,
+}
+
 #[derive(Debug, Clone, PartialEq, Eq, PartialOrd, Ord, Hash)]
 pub struct IDA {
     ida_path: Option<PathBuf>,
+    batch_path: Option<PathBuf>,
     fdb_path: Option<PathBuf>,
     overwrite: bool,
+    rebase: Option<Rebase>,
+    file_backed: bool,
+    cache_dir: Option<PathBuf>,
+    ranges: Vec<(u64, u64)>,
+    functions: Option<String>,
+    reachable_from: Option<(u64, Option<usize>)>,
+    strings: bool,
+    locality: bool,
+    dominators: bool,
+    call_graph: bool,
+    constants: ConstantIndex,
+    large_image: Option<bool>,
     wine: bool,
 }
 
@@ -68,8 +121,21 @@ impl Default for IDA {
     fn default() -> Self {
         Self {
             ida_path: None,
+            batch_path: None,
             fdb_path: None,
             overwrite: false,
+            rebase: None,
+            file_backed: false,
+            cache_dir: None,
+            ranges: Vec::new(),
+            functions: None,
+            reachable_from: None,
+            strings: false,
+            locality: false,
+            dominators: false,
+            call_graph: false,
+            constants: ConstantIndex::None,
+            large_image: None,
             wine: false,
         }
     }
@@ -106,39 +172,394 @@ impl IDA {
         Ok(Self { ida_path: Some(ida_path), wine, ..Default::default() })
     }
 
+    /// Use the headless batch exporter at `path` for [`IDA::import_batch`];
+    /// by default, `fugue-batch` is looked for alongside IDA Pro.
+    pub fn batch_exporter<P: AsRef<Path>>(mut self, path: P) -> Self {
+        self.batch_path = Some(path.as_ref().to_owned());
+        self
+    }
+
     pub fn export_path<P: AsRef<Path>>(mut self, path: P, overwrite: bool) -> Self {
         self.fdb_path = Some(path.as_ref().to_owned());
         self.overwrite = overwrite;
         self
     }
-}
 
-impl Backend for IDA {
-    type Error = Error;
+    pub fn rebase(mut self, rebase: Rebase) -> Self {
+        self.rebase = Some(rebase);
+        self
+    }
 
-    fn name(&self) -> &'static str {
-        "fugue-idapro"
+    /// Reference file-backed segment contents by their offset within the
+    /// input file rather than embedding them; only patched and non-file-backed
+    /// bytes are stored in the exported database.
+    pub fn file_backed(mut self, file_backed: bool) -> Self {
+        self.file_backed = file_backed;
+        self
     }
 
-    fn is_available(&self) -> bool {
-        self.ida_path.is_some()
+    /// Keep analysed databases in `path`, keyed by the input's SHA-256 and the
+    /// IDA Pro executable's size and modification time, and reuse them for
+    /// later exports of the same input rather than repeating auto-analysis.
+    ///
+    /// NOTE: IDA Pro locks a database while it is open, so concurrent exports
+    /// of the same input will not share a cached database. The IDA Pro build
+    /// is not queried; an upgrade that preserves the executable's size and
+    /// modification time will reuse databases from the previous build.
+    pub fn cache_dir<P: AsRef<Path>>(mut self, path: P) -> Self {
+        self.cache_dir = Some(path.as_ref().to_owned());
+        self
     }
 
-    fn is_preferred_for(&self, path: &Url) -> Option<bool> {
-        if path.scheme() != "file" {
-            return None
+    /// Only export functions within the given `[start, end)` address ranges,
+    /// along with the segments overlapping them. Filters intersect; function
+    /// ids remain dense and references to excluded functions are marked as
+    /// external.
+    pub fn ranges<I: IntoIterator<Item = (u64, u64)>>(mut self, ranges: I) -> Self {
+        self.ranges = ranges.into_iter().collect();
+        self
+    }
+
+    /// Only export functions whose names match the regular expression
+    /// `pattern` (ECMAScript syntax).
+    pub fn functions<S: Into<String>>(mut self, pattern: S) -> Self {
+        self.functions = Some(pattern.into());
+        self
+    }
+
+    /// Only export functions reachable through calls from the function
+    /// containing `address`, optionally within `depth` calls. The export fails
+    /// with `Error::Filter` if `address` is not within a function.
+    pub fn reachable_from(mut self, address: u64, depth: Option<usize>) -> Self {
+        self.reachable_from = Some((address, depth));
+        self
+    }
+
+    /// Export the string literals in IDA Pro's string list (disabled by
+    /// default).
+    pub fn strings(mut self, strings: bool) -> Self {
+        self.strings = strings;
+        self
+    }
+
+    /// Order blocks within each function in reverse postorder and lay out
+    /// functions such that callees tend to follow their callers. The `layout`
+    /// and `block_layout` auxiliary tables map the exported order back to IDA
+    /// Pro's.
+    pub fn locality(mut self, locality: bool) -> Self {
+        self.locality = locality;
+        self
+    }
+
+    /// Export each block's immediate dominator and post-dominator, and its
+    /// innermost natural loop and loop nesting depth (disabled by default).
+    pub fn dominators(mut self, dominators: bool) -> Self {
+        self.dominators = dominators;
+        self
+    }
+
+    /// Export the strongly connected components of the call graph, numbered
+    /// bottom-up with a level schedule (disabled by default).
+    pub fn call_graph(mut self, call_graph: bool) -> Self {
+        self.call_graph = call_graph;
+        self
+    }
+
+    /// Export a value-sorted index of the immediate and displacement operands
+    /// of every instruction, with their addresses and blocks (none by
+    /// default, as each instruction is decoded again to build it).
+    pub fn constants(mut self, constants: ConstantIndex) -> Self {
+        self.constants = constants;
+        self
+    }
+
+    /// Store segment contents out of line, in a file named after the export
+    /// with a `.segments` suffix, rather than within the FDB (which is limited
+    /// to 2 GiB). By default (`None`), this is done when the exported
+    /// segments exceed 1 GiB.
+    pub fn large_image(mut self, large_image: Option<bool>) -> Self {
+        self.large_image = large_image;
+        self
+    }
+
+    fn hex(bytes: &[u8]) -> String {
+        bytes.iter().map(|b| format!("{:02x}", b)).collect()
+    }
+
+    // NOTE: the IDA Pro build is not queried (that would cost a launch);
+    // its executable's size and modification time stand in for it, which is
+    // a heuristic that holds for installs and upgrades in place
+    fn cache_key(program: &Path, ida_path: &Path) -> Result<String, Error> {
+        let mut input = fs::File::open(program).map_err(Error::Cache)?;
+        let mut hasher = Sha256::new();
+        io::copy(&mut input, &mut hasher).map_err(Error::Cache)?;
+        let input_hash = hasher.finalize();
+
+        let ida = fs::metadata(ida_path).map_err(Error::Cache)?;
+        let ida_mtime = ida
+            .modified()
+            .ok()
+            .and_then(|t| t.duration_since(std::time::UNIX_EPOCH).ok())
+            .map(|d| d.as_secs())
+            .unwrap_or(0);
+
+        let mut hasher = Sha256::new();
+        hasher.update(ida.len().to_le_bytes());
+        hasher.update(ida_mtime.to_le_bytes());
+        let ida_hash = hasher.finalize();
+
+        Ok(format!("{}-{}", Self::hex(&input_hash), Self::hex(&ida_hash[..8])))
+    }
+
+    // NOTE: pending databases are unique to each export, so that concurrent
+    // exports of the same input, in this process or others, do not collide
+    fn pending_path(cache_dir: &Path, key: &str) -> PathBuf {
+        static PENDING: AtomicUsize = AtomicUsize::new(0);
+        let n = PENDING.fetch_add(1, Ordering::Relaxed);
+        cache_dir.join(format!("{}.{}.{}.pending.i64", key, process::id(), n))
+    }
+
+    /// Exports one database per entry in `rebases` from a single analysis of
+    /// `program`. Databases are written to a fresh temporary directory; the
+    /// returned vector is in the same order as `rebases`.
+    pub fn import_rebased(&self, program: &Url, rebases: &[Rebase]) -> Result<Vec<Imported>, Error> {
+        if rebases.is_empty() {
+            return Ok(Vec::new())
         }
 
-        if let Ok(path) = path.to_file_path() {
-            path.extension()
-                .map(|ext| Some(ext == "i64" || ext == "idb"))
-                .unwrap_or(Some(false))
+        let tmp = tempdir()
+            .map_err(Error::TempDirectory)?
+            .into_path();
+
+        let outputs = rebases
+            .iter()
+            .enumerate()
+            .map(|(i, rebase)| (tmp.join(format!("fugue-temp-export-{}.fdb", i)), Some(*rebase)))
+            .collect::<Vec<_>>();
+
+        self.run(program, &outputs, true)?;
+
+        Ok(outputs.into_iter().map(|(output, _)| Imported::File(output)).collect())
+    }
+
+    fn batch_exporter_path(&self, ida_path: &Path) -> Result<PathBuf, Error> {
+        if let Some(ref batch_path) = self.batch_path {
+            return Ok(batch_path.to_owned())
+        }
+
+        let name = if self.wine { "fugue-batch.exe" } else { "fugue-batch" };
+        let local = ida_path.with_file_name(name);
+
+        if local.exists() {
+            Ok(local)
         } else {
-            None
+            which(name).map_err(Error::InvalidPath)
         }
     }
 
-    fn import(&self, program: &Url) -> Result<Imported, Self::Error> {
+    // NOTE: a cache hit is opened in place by the batch exporter; on a miss,
+    // the new database is kept next to its entry and moved into place once
+    // the export succeeds, as for a single export
+    fn batch_input(&self, program: &Url, ida_path: &Path) -> Result<(PathBuf, Option<(PathBuf, PathBuf)>), Error> {
+        if program.scheme() != "file" {
+            return Err(Error::UnsupportedScheme(program.scheme().to_owned()))
+        }
+
+        let program = program.to_file_path()
+            .map_err(|_| Error::UnsupportedScheme(program.scheme().to_owned()))?;
+
+        let load_existing = program
+            .extension()
+            .map(|e| e == "i64" || e == "idb")
+            .unwrap_or(false);
+
+        match self.cache_dir {
+            Some(ref cache_dir) if !load_existing => {
+                fs::create_dir_all(cache_dir).map_err(Error::Cache)?;
+
+                let key = Self::cache_key(&program, ida_path)?;
+                let entry = cache_dir.join(format!("{}.i64", key));
+
+                if entry.exists() {
+                    Ok((entry, None))
+                } else {
+                    let pending = Self::pending_path(cache_dir, &key);
+                    Ok((program, Some((pending, entry))))
+                }
+            }
+            _ => Ok((program, None)),
+        }
+    }
+
+    /// Exports each of `programs` within a single headless IDA Pro process,
+    /// such that IDA Pro's start-up cost is paid once per batch rather than
+    /// once per program. Databases are written to a fresh temporary directory
+    /// and rebased as configured by [`IDA::rebase`]; the returned vector holds
+    /// the outcome of each export in the same order as `programs`.
+    ///
+    /// NOTE: the batch exporter (`fugue-batch`) is built against IDA Pro's
+    /// idalib, and so requires IDA Pro 9.0 or higher.
+    pub fn import_batch(&self, programs: &[Url]) -> Result<Vec<Result<Imported, Error>>, Error> {
+        if programs.is_empty() {
+            return Ok(Vec::new())
+        }
+
+        let ida_path = self.ida_path.as_ref().ok_or_else(|| Error::NotAvailable)?;
+        let batch_path = self.batch_exporter_path(ida_path)?;
+
+        let tmp = tempdir()
+            .map_err(Error::TempDirectory)?
+            .into_path();
+
+        let manifest_path = tmp.join("fugue-batch-manifest");
+        let results_path = tmp.join("fugue-batch-results");
+
+        let mut outcomes = Vec::with_capacity(programs.len());
+        let mut jobs = Vec::new();
+
+        let mut manifest = fs::File::create(&manifest_path).map_err(Error::TempDirectory)?;
+        for (i, program) in programs.iter().enumerate() {
+            match self.batch_input(program, ida_path) {
+                Ok((input, cache_entry)) => {
+                    let output = tmp.join(format!("fugue-temp-export-{}.fdb", i));
+                    if let Some((ref pending, _)) = cache_entry {
+                        writeln!(manifest, "{}\t{}\t{}", input.display(), output.display(), pending.display())
+                    } else {
+                        writeln!(manifest, "{}\t{}", input.display(), output.display())
+                    }
+                    .map_err(Error::TempDirectory)?;
+                    outcomes.push(None);
+                    jobs.push((i, output, cache_entry));
+                }
+                Err(e) => outcomes.push(Some(Err(e))),
+            }
+        }
+        drop(manifest);
+
+        if !jobs.is_empty() {
+            let mut cmd = if !self.wine {
+                process::Command::new(&batch_path)
+            } else {
+                let mut process = process::Command::new("wine");
+                process.arg(&batch_path);
+                process
+            };
+
+            if let Some(ida_dir) = ida_path.parent() {
+                cmd.env("IDADIR", ida_dir);
+            }
+
+            cmd.args(self.export_options(&[self.rebase], true));
+            cmd.arg(&manifest_path);
+            cmd.arg(&results_path);
+
+            let status = cmd
+                .output()
+                .map_err(Error::Launch)?
+                .status
+                .code();
+
+            // NOTE: results are recorded as each program is exported, so the
+            // exports completed before a failure of the batch are kept
+            if let Ok(results) = fs::File::open(&results_path) {
+                for line in io::BufReader::new(results).lines().flatten() {
+                    let mut parts = line.splitn(2, '\t');
+                    let job = parts.next().and_then(|job| job.parse::<usize>().ok());
+                    let code = parts.next().and_then(|code| code.parse::<i32>().ok());
+
+                    if let (Some((i, output, _)), Some(code)) = (job.and_then(|job| jobs.get(job)), code) {
+                        outcomes[*i] = Some(Self::status(Some(code)).map(|_| Imported::File(output.clone())));
+                    }
+                }
+            }
+
+            for (i, _, cache_entry) in jobs.iter() {
+                if outcomes[*i].is_none() {
+                    outcomes[*i] = Some(Self::status(status).and(Err(Error::Failure)));
+                }
+
+                // NOTE: caching is best-effort, as for a single export
+                if let Some((pending, entry)) = cache_entry {
+                    let cached = matches!(outcomes[*i], Some(Ok(_))) && fs::rename(pending, entry).is_ok();
+                    if !cached {
+                        let _ = fs::remove_file(pending);
+                    }
+                }
+            }
+        }
+
+        Ok(outcomes.into_iter().map(|outcome| outcome.unwrap()).collect())
+    }
+
+    // NOTE: options other than the outputs are shared by the plugin and the
+    // batch exporter
+    fn export_options(&self, rebases: &[Option<Rebase>], overwrite: bool) -> Vec<String> {
+        let mut opts = vec![format!("-OFugueForceOverwrite:{}", overwrite)];
+
+        if self.file_backed {
+            opts.push(format!("-OFugueFileBacked:true"));
+        }
+
+        if self.strings {
+            opts.push(format!("-OFugueStrings:true"));
+        }
+
+        if self.dominators {
+            opts.push(format!("-OFugueDominators:true"));
+        }
+
+        if self.call_graph {
+            opts.push(format!("-OFugueCallGraph:true"));
+        }
+
+        if self.locality {
+            opts.push(format!("-OFugueLocality:true"));
+        }
+
+        if let Some(large_image) = self.large_image {
+            opts.push(format!("-OFugueLargeImage:{}", large_image));
+        }
+
+        match self.constants {
+            ConstantIndex::None => (),
+            ConstantIndex::Plain => opts.push(format!("-OFugueConstants:plain")),
+            ConstantIndex::Delta => opts.push(format!("-OFugueConstants:delta")),
+        }
+
+        if !self.ranges.is_empty() {
+            let ranges = self.ranges
+                .iter()
+                .map(|(start, end)| format!("{:#x}-{:#x}", start, end))
+                .collect::<Vec<_>>();
+            opts.push(format!("-OFugueRanges:{}", ranges.join(",")));
+        }
+
+        if let Some(ref pattern) = self.functions {
+            opts.push(format!("-OFugueFunctions:{}", pattern));
+        }
+
+        if let Some((address, depth)) = self.reachable_from {
+            if let Some(depth) = depth {
+                opts.push(format!("-OFugueReachableFrom:{:#x},{}", address, depth));
+            } else {
+                opts.push(format!("-OFugueReachableFrom:{:#x}", address));
+            }
+        }
+
+        // NOTE: the exporter pairs each rebase with the output at the same
+        // position; an unrebased output within a list is a zero delta
+        if rebases.iter().any(|rebase| rebase.is_some()) {
+            let rebases = rebases
+                .iter()
+                .map(|rebase| rebase.unwrap_or(Rebase::Relative(0)).to_option())
+                .collect::<Vec<_>>();
+            opts.push(format!("-OFugueRebase:{}", rebases.join(",")));
+        }
+
+        opts
+    }
+
+    fn run(&self, program: &Url, outputs: &[(PathBuf, Option<Rebase>)], overwrite: bool) -> Result<(), Error> {
         if program.scheme() != "file" {
             return Err(Error::UnsupportedScheme(program.scheme().to_owned()))
         }
@@ -157,6 +578,28 @@ impl Backend for IDA {
         let force_32bit =
             load_existing && program.extension().map(|e| e == "idb").unwrap_or(false);
 
+        // NOTE: a cache hit is loaded as an existing database; on a miss the
+        // new database is written next to its entry and moved into place only
+        // once the export succeeds
+        let mut cache_entry = None;
+        let (program, load_existing) = match self.cache_dir {
+            Some(ref cache_dir) if !load_existing => {
+                fs::create_dir_all(cache_dir).map_err(Error::Cache)?;
+
+                let key = Self::cache_key(&program, ida_path)?;
+                let entry = cache_dir.join(format!("{}.i64", key));
+
+                if entry.exists() {
+                    (entry, true)
+                } else {
+                    let pending = Self::pending_path(cache_dir, &key);
+                    cache_entry = Some((pending, entry));
+                    (program, false)
+                }
+            }
+            _ => (program, load_existing),
+        };
+
         let mut cmd = if !self.wine {
             if force_32bit {
                 process::Command::new(format!(
@@ -181,54 +624,108 @@ impl Backend for IDA {
 
         cmd.arg("-A");
 
-        let mut tmp = tempdir()
-            .map_err(Error::TempDirectory)?
-            .into_path();
-
-        let output = if let Some(ref fdb_path) = self.fdb_path {
-            fdb_path.to_owned()
-        } else {
-            tmp.join("fugue-temp-export.fdb")
-        };
-
-        let opts = vec![
-            format!("-OFugueOutput:{}", output.display()),
-            format!("-OFugueForceOverwrite:{}", self.overwrite),
-        ];
-
-        /*
-        if let Some(rebase) = rebase {
-            if rebase_relative > 0 {
-                opts.push(format!("-OFugueRebase:+{:#x}", rebase));
-            } else if rebase_relative < 0 {
-                opts.push(format!("-OFugueRebase:-{:#x}", rebase));
-            } else {
-                opts.push(format!("-OFugueRebase:{:#x}", rebase));
-            }
-        }
-        */
+        // NOTE: outputs after the first are passed as `FugueOutput1`,
+        // `FugueOutput2`, etc., so that their paths may contain any character
+        let mut opts = outputs
+            .iter()
+            .enumerate()
+            .map(|(i, (output, _))| {
+                let index = if i == 0 { String::new() } else { i.to_string() };
+                format!("-OFugueOutput{}:{}", index, output.display())
+            })
+            .collect::<Vec<_>>();
+        opts.extend(self.export_options(
+            &outputs.iter().map(|(_, rebase)| *rebase).collect::<Vec<_>>(),
+            overwrite,
+        ));
 
         if load_existing {
             cmd.args(&opts);
             cmd.arg(&format!("{}", program.display()));
+        } else if let Some((ref pending, _)) = cache_entry {
+            opts.push(format!("-OFugueKeepDatabase:true"));
+            cmd.arg(&format!("-o{}", pending.display()));
+            cmd.args(&opts);
+            cmd.arg(&format!("{}", program.display()));
         } else {
+            let mut tmp = tempdir()
+                .map_err(Error::TempDirectory)?
+                .into_path();
+
             tmp.push("fugue-import-tmp.ida");
             cmd.arg(&format!("-o{}", tmp.display()));
             cmd.args(&opts);
             cmd.arg(&format!("{}", program.display()));
         }
 
-        match cmd
+        let status = cmd
             .output()
             .map_err(Error::Launch)
-            .map(|output| output.status.code())?
+            .map(|output| output.status.code());
+
+        if let Some((pending, entry)) = cache_entry {
+            // NOTE: caching is best-effort; a failed export or move leaves no
+            // entry behind and the next export analyses from scratch
+            let cached = matches!(status, Ok(Some(100))) && fs::rename(&pending, &entry).is_ok();
+            if !cached {
+                let _ = fs::remove_file(&pending);
+            }
+        }
+
+        Self::status(status?)
+    }
+
+    fn status(code: Option<i32>) -> Result<(), Error> {
+        match code
         {
-            Some(100) => Ok(Imported::File(output)),
+            Some(100) => Ok(()),
             Some(101) => Err(Error::InputOutput)?,
             Some(102) => Err(Error::Import)?,
             Some(103) => Err(Error::Unsupported)?,
             Some(104) => Err(Error::Rebase)?,
+            Some(105) => Err(Error::Filter)?,
             _ => Err(Error::Failure)?,
         }
     }
 }
+
+impl Backend for IDA {
+    type Error = Error;
+
+    fn name(&self) -> &'static str {
+        "fugue-idapro"
+    }
+
+    fn is_available(&self) -> bool {
+        self.ida_path.is_some()
+    }
+
+    fn is_preferred_for(&self, path: &Url) -> Option<bool> {
+        if path.scheme() != "file" {
+            return None
+        }
+
+        if let Ok(path) = path.to_file_path() {
+            path.extension()
+                .map(|ext| Some(ext == "i64" || ext == "idb"))
+                .unwrap_or(Some(false))
+        } else {
+            None
+        }
+    }
+
+    fn import(&self, program: &Url) -> Result<Imported, Self::Error> {
+        let output = if let Some(ref fdb_path) = self.fdb_path {
+            fdb_path.to_owned()
+        } else {
+            tempdir()
+                .map_err(Error::TempDirectory)?
+                .into_path()
+                .join("fugue-temp-export.fdb")
+        };
+
+        self.run(program, &[(output.clone(), self.rebase)], self.overwrite)?;
+
+        Ok(Imported::File(output))
+    }
+}
@@ -0,0 +1,296 @@
+#include <idalib.hpp>
+#include <ida.hpp>
+#include <idp.hpp>
+#include <kernwin.hpp>
+#include <loader.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#include <fugue_export.h>
+
+// Headless batch exporter: runs the exporter over a list of inputs within a
+// single process, such that IDA's kernel and plugins are initialised once per
+// batch rather than once per input.
+//
+// Usage: fugue-batch [-OFugue<name>:<value>]... <manifest> <results>
+//
+// Each line of `manifest` names an input and its outputs, separated by tabs,
+// with one output per base given to `-OFugueRebase` (or one if unset). A
+// further, optional, field gives the path at which to keep the input's
+// database. The options are those accepted by the plugin, and apply to every
+// input. For each input, a line holding its position within `manifest` and
+// its exit code, separated by a tab, is appended to `results` once it is
+// exported.
+//
+// Databases are created in a temporary directory and removed after each
+// export unless kept, at the manifest's path or, with
+// `-OFugueKeepDatabase:true`, at the first output's path with `.i64` appended.
+
+namespace fugue
+{
+  namespace batch
+  {
+    struct Job
+    {
+      std::string input;
+      std::vector<std::string> outputs;
+      std::string database;
+    };
+
+    bool parse_manifest(const char *path, size_t output_count, std::vector<Job> *jobs)
+    {
+      auto manifest = std::ifstream(path);
+      if (!manifest)
+      {
+        return false;
+      }
+
+      auto line = std::string();
+      while (std::getline(manifest, line))
+      {
+        if (!line.empty() && line.back() == '\r')
+        {
+          line.pop_back();
+        }
+
+        if (line.empty())
+        {
+          continue;
+        }
+
+        auto fields = split_opt(line, '\t');
+
+        auto has_database = std::size(fields) == output_count + 2;
+        if (std::size(fields) != output_count + 1 && !has_database)
+        {
+          return false;
+        }
+
+        if (std::any_of(std::begin(fields), std::end(fields), [](auto const &field) { return field.empty(); }))
+        {
+          return false;
+        }
+
+        auto database = has_database ? fields.back() : std::string();
+        auto outputs = std::vector<std::string>(std::begin(fields) + 1, std::begin(fields) + 1 + output_count);
+
+        jobs->push_back(Job{fields[0], outputs, database});
+      }
+
+      return true;
+    }
+
+    inline bool is_database(std::filesystem::path const &path)
+    {
+      auto extension = path.extension();
+      return extension == ".i64" || extension == ".idb";
+    }
+
+    // per-process directory for job databases
+    std::filesystem::path make_scratch()
+    {
+      auto random = std::random_device();
+      auto ec = std::error_code();
+
+      for (auto attempt = 0; attempt != 16; ++attempt)
+      {
+        auto path = std::filesystem::temp_directory_path(ec) / ("fugue-batch-" + std::to_string(random()));
+        if (!ec && std::filesystem::create_directory(path, ec))
+        {
+          return path;
+        }
+      }
+
+      return std::filesystem::path();
+    }
+
+    // opens `input` with its database at `database`; IDA Pro 9.0 opens a link
+    // to the input named after the database
+    int open_job_database(std::filesystem::path const &input, std::filesystem::path const &database)
+    {
+#if IDA_SDK_VERSION >= 910
+      auto args = "-o\"" + database.string() + "\"";
+      return open_database(input.string().c_str(), true, args.c_str());
+#else
+      auto ec = std::error_code();
+      auto link = std::filesystem::path(database).replace_extension();
+
+      std::filesystem::create_symlink(std::filesystem::absolute(input, ec), link, ec);
+      if (ec && !std::filesystem::copy_file(input, link, ec))
+      {
+        return -1;
+      }
+
+      return open_database(link.string().c_str(), true);
+#endif
+    }
+
+    // moves a kept database, copying it across file systems
+    bool keep_database(std::filesystem::path const &from, std::filesystem::path const &to)
+    {
+      auto ec = std::error_code();
+
+      std::filesystem::rename(from, to, ec);
+      if (!ec)
+      {
+        return true;
+      }
+
+      return std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing, ec);
+    }
+
+    int export_job(Job const &job, size_t index, std::map<std::string, std::string> const &options, std::filesystem::path const &scratch)
+    {
+      auto argument = [&](const char *name) -> std::string {
+        // NOTE: outputs after the first are given as `Output1`, `Output2`, etc.
+        if (auto option = std::string(name); option.rfind("Output", 0) == 0)
+        {
+          auto output = option == "Output" ? size_t(0) : std::stoul(option.substr(std::size("Output") - 1));
+          return output < std::size(job.outputs) ? job.outputs[output] : "";
+        }
+
+        auto option = options.find(std::string("Fugue") + name);
+        return option != std::end(options) ? option->second : "";
+      };
+
+      auto input = std::filesystem::path(job.input);
+      auto existing = is_database(input);
+
+      auto keep = !job.database.empty() || opt_true(argument("KeepDatabase"));
+      auto kept = std::filesystem::path(job.database);
+      if (kept.empty())
+      {
+        kept = job.outputs[0] + ".i64";
+      }
+
+      auto ec = std::error_code();
+      auto job_dir = scratch / std::to_string(index);
+      auto database = job_dir / (input.filename().string() + ".i64");
+
+      if (existing)
+      {
+        if (open_database(job.input.c_str(), true) != 0)
+        {
+          return EXIT_IMPORT_ERROR;
+        }
+      }
+      else if (scratch.empty() || !std::filesystem::create_directories(job_dir, ec) || open_job_database(input, database) != 0)
+      {
+        std::filesystem::remove_all(job_dir, ec);
+        return EXIT_IMPORT_ERROR;
+      }
+
+      auto success = EXIT_IMPORT_ERROR;
+      try
+      {
+        success = ida::export_database(argument);
+      }
+      catch (std::exception &ex)
+      {
+        msg("Fugue IDB exporter: export of `%s` failed with error: %s\n", job.input.c_str(), ex.what());
+      }
+
+      if (existing)
+      {
+        close_database(keep);
+        return success;
+      }
+
+      if (!keep)
+      {
+        set_database_flag(DBFL_KILL);
+      }
+
+      close_database(keep);
+
+      if (keep && !keep_database(database, kept))
+      {
+        msg("Fugue IDB exporter: could not keep database of `%s` at `%s`\n", job.input.c_str(), kept.string().c_str());
+      }
+
+      std::filesystem::remove_all(job_dir, ec);
+
+      return success;
+    }
+
+  }; // namespace batch
+};   // namespace fugue
+
+int main(int argc, char *argv[])
+{
+  using namespace fugue;
+
+  auto options = std::map<std::string, std::string>();
+  auto paths = std::vector<const char *>();
+
+  for (auto i = 1; i < argc; ++i)
+  {
+    auto arg = std::string(argv[i]);
+    if (arg.rfind("-O", 0) == 0)
+    {
+      auto sep = arg.find(':');
+      if (sep == std::string::npos)
+      {
+        std::cerr << "fugue-batch: malformed option `" << arg << "`" << std::endl;
+        return EXIT_IO_ERROR;
+      }
+      options[arg.substr(2, sep - 2)] = arg.substr(sep + 1);
+    }
+    else
+    {
+      paths.push_back(argv[i]);
+    }
+  }
+
+  if (std::size(paths) != 2)
+  {
+    std::cerr << "usage: fugue-batch [-OFugue<name>:<value>]... <manifest> <results>" << std::endl;
+    return EXIT_IO_ERROR;
+  }
+
+  auto output_count = std::max<size_t>(std::size(split_opt(options["FugueRebase"])), 1);
+
+  auto jobs = std::vector<batch::Job>();
+  if (!batch::parse_manifest(paths[0], output_count, &jobs))
+  {
+    std::cerr << "fugue-batch: could not read manifest `" << paths[0] << "`" << std::endl;
+    return EXIT_IO_ERROR;
+  }
+
+  // NOTE: flushed per input, so interrupted batches keep their results
+  auto results = std::ofstream(paths[1], std::ios::out | std::ios::trunc);
+  if (!results)
+  {
+    std::cerr << "fugue-batch: could not open results `" << paths[1] << "`" << std::endl;
+    return EXIT_IO_ERROR;
+  }
+
+  if (init_library() != 0)
+  {
+    std::cerr << "fugue-batch: could not initialise IDA Pro" << std::endl;
+    return EXIT_IMPORT_ERROR;
+  }
+
+  enable_console_messages(false);
+
+  auto scratch = batch::make_scratch();
+  if (scratch.empty())
+  {
+    std::cerr << "fugue-batch: could not create a temporary directory" << std::endl;
+    return EXIT_IO_ERROR;
+  }
+
+  for (size_t i = 0; i < std::size(jobs); ++i)
+  {
+    auto success = batch::export_job(jobs[i], i, options, scratch);
+    results << i << '\t' << success << std::endl;
+  }
+
+  auto ec = std::error_code();
+  std::filesystem::remove_all(scratch, ec);
+
+  return EXIT_OK;
+}
@@ -0,0 +1,611 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fugue_analysis.h>
+#include <fugue_reader.h>
+
+// Structural diff of two FDBs: functions are matched by name, then by
+// content, then by address; blocks within matched functions are matched by
+// content, then by offset from their function's address.
+//
+// Usage: fugue-diff [-j <threads>] <old.fdb> <new.fdb> [<output>]
+//
+// The diff is written as tab-separated lines (addresses in hex):
+//
+//   F-  <old address>  <name>
+//   F+  <new address>  <name>
+//   F~  <old address>  <new address>  <name>  <removed>  <added>  <changed>
+//   E-  <old function>  <old source>  <old target>
+//   E+  <new function>  <new source>  <new target>
+//
+// where F~ counts the blocks removed, added and changed within a modified
+// function, and its edge changes follow it.
+
+namespace fugue
+{
+  namespace diff
+  {
+    const uint32_t UNMATCHED = std::numeric_limits<uint32_t>::max();
+
+    inline uint64_t mix(uint64_t value)
+    {
+      value ^= value >> 33;
+      value *= 0xff51afd7ed558ccdULL;
+      value ^= value >> 33;
+      value *= 0xc4ceb9fe1a85ec53ULL;
+      value ^= value >> 33;
+      return value;
+    }
+
+    inline uint64_t hash_bytes(const uint8_t *data, size_t size)
+    {
+      auto hash = mix(size);
+
+      size_t i = 0;
+      for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+      {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = mix(hash ^ word);
+      }
+
+      uint64_t tail = 0;
+      std::memcpy(&tail, data + i, size - i);
+      return mix(hash ^ tail);
+    }
+
+    struct SegmentRange
+    {
+      uint64_t start;
+      const uint8_t *bytes;
+      size_t size;
+    };
+
+    struct FunctionSummary
+    {
+      uint64_t address;
+      std::string_view name;
+      uint64_t hash;
+      uint32_t blocks;
+      uint32_t edges;
+    };
+
+    class Database
+    {
+    public:
+      // NOTE: only the project table is verified here; functions are
+      // verified as they are summarised
+      inline bool open(const char *path)
+      {
+        if (!reader.open(path))
+        {
+          std::fprintf(stderr, "fugue-diff: `%s` is not a valid FDB\n", path);
+          return false;
+        }
+
+        for (size_t i = 0; i != reader.segment_count(); ++i)
+        {
+          auto segment = reader.segment(i);
+          if (segment == nullptr)
+          {
+            std::fprintf(stderr, "fugue-diff: `%s` is not a valid FDB\n", path);
+            return false;
+          }
+
+          // NOTE: file-backed contents are in the input file, not available here
+          if (reader.segment_file_range(i).has_value())
+          {
+            std::fprintf(stderr, "fugue-diff: `%s` has file-backed segments, which cannot be diffed; export it without -OFugueFileBacked\n", path);
+            return false;
+          }
+
+          auto contents = reader.segment_contents(i);
+          if (!contents.has_value())
+          {
+            std::fprintf(stderr, "fugue-diff: the segment contents of `%s` are missing (expected in `%s.segments`)\n", path, path);
+            return false;
+          }
+
+          auto bytes = contents->bytes;
+          segments.push_back(SegmentRange{contents->address, bytes.empty() ? nullptr : bytes.data(), bytes.size()});
+        }
+
+        std::sort(std::begin(segments), std::end(segments), [](auto const &l, auto const &r) {
+          return l.start < r.start;
+        });
+
+        return true;
+      }
+
+      inline uint64_t block_hash(const schema::BasicBlock *block) const
+      {
+        auto address = block->address();
+        auto size = block->size();
+
+        auto segment = std::upper_bound(std::begin(segments), std::end(segments), address, [](uint64_t address, auto const &segment) {
+          return address < segment.start;
+        });
+
+        if (segment != std::begin(segments))
+        {
+          --segment;
+          if (segment->bytes != nullptr && address - segment->start + size <= segment->size)
+          {
+            return hash_bytes(segment->bytes + (address - segment->start), size);
+          }
+        }
+
+        return mix(size);
+      }
+
+      inline size_t function_count() const
+      {
+        return reader.function_count();
+      }
+
+      inline const schema::Function *function(size_t index) const
+      {
+        return reader.function(index);
+      }
+
+      // NOTE: a function's hash combines its blocks' contents, offsets and
+      // edges independently of their order; returns false if any function
+      // fails verification
+      inline bool summarise(size_t threads)
+      {
+        summaries.resize(function_count());
+
+        auto valid = std::atomic<bool>(true);
+
+        parallel_for(
+            function_count(),
+            threads,
+            [] { return 0; },
+            [&](int, size_t index) {
+              auto fn = function(index);
+              auto &summary = summaries[index];
+
+              if (fn == nullptr)
+              {
+                summary = FunctionSummary{0, std::string_view(), 0, 0, 0};
+                valid = false;
+                return;
+              }
+
+              summary.address = fn->address();
+              summary.name = fn->symbol() != nullptr ? std::string_view(fn->symbol()->c_str(), fn->symbol()->size()) : std::string_view();
+              summary.hash = 0;
+              summary.blocks = 0;
+              summary.edges = 0;
+
+              auto blocks = fn->blocks();
+              if (blocks == nullptr)
+              {
+                return;
+              }
+
+              summary.blocks = blocks->size();
+              for (auto block : *blocks)
+              {
+                auto offset = block->address() - summary.address;
+                summary.hash += mix(block_hash(block) ^ mix(offset));
+
+                if (auto succs = block->successors())
+                {
+                  summary.edges += succs->size();
+                  for (auto succ : *succs)
+                  {
+                    auto target = static_cast<flatbuffers::uoffset_t>(succ->target() & 0xffffffffULL);
+                    if (target < blocks->size())
+                    {
+                      summary.hash += mix(mix(offset) ^ (blocks->Get(target)->address() - summary.address));
+                    }
+                  }
+                }
+              }
+            });
+
+        return valid;
+      }
+
+      std::vector<FunctionSummary> summaries;
+
+    private:
+      FdbReader reader;
+      std::vector<SegmentRange> segments;
+    };
+
+    // pairs up unmatched items whose keys are unique on both sides; `olds`
+    // and `news` hold (key, index) pairs and are reordered
+    template <typename Key>
+    inline void match_unique(
+        std::vector<std::pair<Key, uint32_t>> &olds,
+        std::vector<std::pair<Key, uint32_t>> &news,
+        std::vector<uint32_t> &old_match,
+        std::vector<uint32_t> &new_match)
+    {
+      std::sort(std::begin(olds), std::end(olds));
+      std::sort(std::begin(news), std::end(news));
+
+      auto i = std::begin(olds);
+      auto j = std::begin(news);
+
+      while (i != std::end(olds) && j != std::end(news))
+      {
+        if (i->first < j->first)
+        {
+          ++i;
+        }
+        else if (j->first < i->first)
+        {
+          ++j;
+        }
+        else
+        {
+          auto key = i->first;
+          auto i_end = std::find_if(i, std::end(olds), [&](auto const &entry) { return !(entry.first == key); });
+          auto j_end = std::find_if(j, std::end(news), [&](auto const &entry) { return !(entry.first == key); });
+
+          if (i_end - i == 1 && j_end - j == 1)
+          {
+            old_match[i->second] = j->second;
+            new_match[j->second] = i->second;
+          }
+
+          i = i_end;
+          j = j_end;
+        }
+      }
+    }
+
+    // NOTE: IDA's placeholder names are derived from addresses and so are
+    // not meaningful across versions
+    inline bool is_placeholder(std::string_view name)
+    {
+      return name.empty() || name.rfind("sub_", 0) == 0 || name.rfind("nullsub_", 0) == 0;
+    }
+
+    inline void match_functions(Database const &old_db, Database const &new_db, std::vector<uint32_t> &old_match, std::vector<uint32_t> &new_match)
+    {
+      auto const &olds = old_db.summaries;
+      auto const &news = new_db.summaries;
+
+      old_match.assign(std::size(olds), UNMATCHED);
+      new_match.assign(std::size(news), UNMATCHED);
+
+      auto by = [&](auto key, auto include) {
+        using Key = decltype(key(olds[0]));
+
+        auto old_keys = std::vector<std::pair<Key, uint32_t>>();
+        auto new_keys = std::vector<std::pair<Key, uint32_t>>();
+
+        for (uint32_t i = 0; i != std::size(olds); ++i)
+        {
+          if (old_match[i] == UNMATCHED && include(olds[i]))
+            old_keys.emplace_back(key(olds[i]), i);
+        }
+
+        for (uint32_t i = 0; i != std::size(news); ++i)
+        {
+          if (new_match[i] == UNMATCHED && include(news[i]))
+            new_keys.emplace_back(key(news[i]), i);
+        }
+
+        match_unique(old_keys, new_keys, old_match, new_match);
+      };
+
+      if (olds.empty() || news.empty())
+      {
+        return;
+      }
+
+      by([](auto const &fn) { return fn.name; }, [](auto const &fn) { return !is_placeholder(fn.name); });
+      by([](auto const &fn) { return fn.hash; }, [](auto const &) { return true; });
+      by([](auto const &fn) { return fn.address; }, [](auto const &) { return true; });
+    }
+
+    struct Scratch
+    {
+      std::vector<uint64_t> old_hashes;
+      std::vector<uint64_t> new_hashes;
+      std::vector<uint32_t> old_match;
+      std::vector<uint32_t> new_match;
+      std::vector<std::pair<uint64_t, uint32_t>> old_keys;
+      std::vector<std::pair<uint64_t, uint32_t>> new_keys;
+      std::vector<uint64_t> new_edges;
+      std::vector<std::pair<uint64_t, uint64_t>> mapped_edges;
+    };
+
+    inline void append_hex(std::string &out, uint64_t value)
+    {
+      char buf[24];
+      auto size = std::snprintf(buf, sizeof(buf), "%llx", static_cast<unsigned long long>(value));
+      out.append(buf, size);
+    }
+
+    // compares a matched pair of functions, appending their report to `out`
+    // if they differ; returns whether they do
+    inline bool diff_functions(const schema::Function *old_fn, const schema::Function *new_fn, Database const &old_db, Database const &new_db, Scratch &scratch, std::string &out)
+    {
+      auto old_blocks = old_fn->blocks();
+      auto new_blocks = new_fn->blocks();
+      auto old_count = old_blocks != nullptr ? old_blocks->size() : 0;
+      auto new_count = new_blocks != nullptr ? new_blocks->size() : 0;
+
+      scratch.old_hashes.resize(old_count);
+      scratch.new_hashes.resize(new_count);
+      scratch.old_match.assign(old_count, UNMATCHED);
+      scratch.new_match.assign(new_count, UNMATCHED);
+
+      for (uint32_t i = 0; i != old_count; ++i)
+        scratch.old_hashes[i] = old_db.block_hash(old_blocks->Get(i));
+      for (uint32_t i = 0; i != new_count; ++i)
+        scratch.new_hashes[i] = new_db.block_hash(new_blocks->Get(i));
+
+      // blocks by content, then by offset within their function
+      scratch.old_keys.clear();
+      scratch.new_keys.clear();
+      for (uint32_t i = 0; i != old_count; ++i)
+        scratch.old_keys.emplace_back(scratch.old_hashes[i], i);
+      for (uint32_t i = 0; i != new_count; ++i)
+        scratch.new_keys.emplace_back(scratch.new_hashes[i], i);
+      match_unique(scratch.old_keys, scratch.new_keys, scratch.old_match, scratch.new_match);
+
+      scratch.old_keys.clear();
+      scratch.new_keys.clear();
+      for (uint32_t i = 0; i != old_count; ++i)
+      {
+        if (scratch.old_match[i] == UNMATCHED)
+          scratch.old_keys.emplace_back(old_blocks->Get(i)->address() - old_fn->address(), i);
+      }
+      for (uint32_t i = 0; i != new_count; ++i)
+      {
+        if (scratch.new_match[i] == UNMATCHED)
+          scratch.new_keys.emplace_back(new_blocks->Get(i)->address() - new_fn->address(), i);
+      }
+      match_unique(scratch.old_keys, scratch.new_keys, scratch.old_match, scratch.new_match);
+
+      size_t removed = 0;
+      size_t changed = 0;
+      for (uint32_t i = 0; i != old_count; ++i)
+      {
+        if (scratch.old_match[i] == UNMATCHED)
+          ++removed;
+        else if (scratch.old_hashes[i] != scratch.new_hashes[scratch.old_match[i]])
+          ++changed;
+      }
+      auto added = static_cast<size_t>(std::count(std::begin(scratch.new_match), std::end(scratch.new_match), UNMATCHED));
+
+      // edges are compared within the new function's block numbering; old
+      // edges with an unmatched endpoint are keyed such that they never
+      // match a new edge
+      auto key = [](uint64_t source, uint64_t target) { return source << 32ULL | target; };
+
+      scratch.new_edges.clear();
+      for (uint32_t i = 0; i != new_count; ++i)
+      {
+        if (auto succs = new_blocks->Get(i)->successors())
+        {
+          for (auto succ : *succs)
+            scratch.new_edges.push_back(key(i, succ->target() & 0xffffffffULL));
+        }
+      }
+
+      scratch.mapped_edges.clear();
+      for (uint32_t i = 0; i != old_count; ++i)
+      {
+        if (auto succs = old_blocks->Get(i)->successors())
+        {
+          for (auto succ : *succs)
+          {
+            auto target = static_cast<uint32_t>(succ->target() & 0xffffffffULL);
+            auto source_match = scratch.old_match[i];
+            auto target_match = target < old_count ? scratch.old_match[target] : UNMATCHED;
+            auto mapped = source_match == UNMATCHED || target_match == UNMATCHED ? std::numeric_limits<uint64_t>::max() : key(source_match, target_match);
+            scratch.mapped_edges.emplace_back(mapped, key(i, target));
+          }
+        }
+      }
+
+      std::sort(std::begin(scratch.new_edges), std::end(scratch.new_edges));
+      std::sort(std::begin(scratch.mapped_edges), std::end(scratch.mapped_edges));
+
+      auto report = std::string();
+
+      for (auto const &[mapped, original] : scratch.mapped_edges)
+      {
+        if (std::binary_search(std::begin(scratch.new_edges), std::end(scratch.new_edges), mapped))
+        {
+          continue;
+        }
+
+        report += "E-\t";
+        append_hex(report, old_fn->address());
+        report += '\t';
+        append_hex(report, old_blocks->Get(static_cast<flatbuffers::uoffset_t>(original >> 32ULL))->address());
+        report += '\t';
+        auto target = static_cast<flatbuffers::uoffset_t>(original & 0xffffffffULL);
+        append_hex(report, target < old_count ? old_blocks->Get(target)->address() : 0);
+        report += '\n';
+      }
+
+      for (auto edge : scratch.new_edges)
+      {
+        auto mapped = std::lower_bound(std::begin(scratch.mapped_edges), std::end(scratch.mapped_edges), std::make_pair(edge, uint64_t(0)));
+        if (mapped != std::end(scratch.mapped_edges) && mapped->first == edge)
+        {
+          continue;
+        }
+
+        report += "E+\t";
+        append_hex(report, new_fn->address());
+        report += '\t';
+        append_hex(report, new_blocks->Get(static_cast<flatbuffers::uoffset_t>(edge >> 32ULL))->address());
+        report += '\t';
+        auto target = static_cast<flatbuffers::uoffset_t>(edge & 0xffffffffULL);
+        append_hex(report, target < new_count ? new_blocks->Get(target)->address() : 0);
+        report += '\n';
+      }
+
+      if (removed == 0 && added == 0 && changed == 0 && report.empty())
+      {
+        return false;
+      }
+
+      out += "F~\t";
+      append_hex(out, old_fn->address());
+      out += '\t';
+      append_hex(out, new_fn->address());
+      out += '\t';
+      out += new_fn->symbol() != nullptr ? new_fn->symbol()->str() : std::string();
+      out += '\t' + std::to_string(removed) + '\t' + std::to_string(added) + '\t' + std::to_string(changed) + '\n';
+      out += report;
+
+      return true;
+    }
+
+  }; // namespace diff
+};   // namespace fugue
+
+int main(int argc, char *argv[])
+{
+  using namespace fugue;
+  using namespace fugue::diff;
+
+  auto start = std::chrono::steady_clock::now();
+
+  auto threads = static_cast<size_t>(std::thread::hardware_concurrency());
+  auto paths = std::vector<const char *>();
+
+  for (auto i = 1; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+    {
+      threads = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else
+    {
+      paths.push_back(argv[i]);
+    }
+  }
+
+  if (std::size(paths) < 2 || std::size(paths) > 3)
+  {
+    std::fprintf(stderr, "usage: fugue-diff [-j <threads>] <old.fdb> <new.fdb> [<output>]\n");
+    return 1;
+  }
+
+  auto old_db = Database();
+  auto new_db = Database();
+  if (!old_db.open(paths[0]) || !new_db.open(paths[1]))
+  {
+    return 1;
+  }
+
+  if (!old_db.summarise(threads) || !new_db.summarise(threads))
+  {
+    std::fprintf(stderr, "fugue-diff: inputs are not valid FDBs\n");
+    return 1;
+  }
+
+  auto old_match = std::vector<uint32_t>();
+  auto new_match = std::vector<uint32_t>();
+  match_functions(old_db, new_db, old_match, new_match);
+
+  auto matches = std::vector<std::pair<uint32_t, uint32_t>>();
+  for (uint32_t i = 0; i != std::size(old_match); ++i)
+  {
+    if (old_match[i] != UNMATCHED)
+      matches.emplace_back(i, old_match[i]);
+  }
+
+  // NOTE: pairs with equal summaries are taken to be unchanged and are not
+  // compared block-by-block
+  auto reports = std::vector<std::string>(std::size(matches));
+  auto modified = std::vector<uint8_t>(std::size(matches), 0);
+
+  parallel_for(
+      std::size(matches),
+      threads,
+      [] { return Scratch(); },
+      [&](Scratch &scratch, size_t index) {
+        auto [old_index, new_index] = matches[index];
+        auto const &old_summary = old_db.summaries[old_index];
+        auto const &new_summary = new_db.summaries[new_index];
+
+        if (old_summary.hash == new_summary.hash && old_summary.blocks == new_summary.blocks && old_summary.edges == new_summary.edges)
+        {
+          return;
+        }
+
+        modified[index] = diff_functions(old_db.function(old_index), new_db.function(new_index), old_db, new_db, scratch, reports[index]);
+      });
+
+  auto out = std::string();
+  size_t removed = 0;
+  size_t added = 0;
+
+  for (uint32_t i = 0; i != std::size(old_match); ++i)
+  {
+    if (old_match[i] == UNMATCHED)
+    {
+      out += "F-\t";
+      append_hex(out, old_db.summaries[i].address);
+      out += '\t';
+      out += old_db.summaries[i].name;
+      out += '\n';
+      ++removed;
+    }
+  }
+
+  for (uint32_t i = 0; i != std::size(new_match); ++i)
+  {
+    if (new_match[i] == UNMATCHED)
+    {
+      out += "F+\t";
+      append_hex(out, new_db.summaries[i].address);
+      out += '\t';
+      out += new_db.summaries[i].name;
+      out += '\n';
+      ++added;
+    }
+  }
+
+  for (auto const &report : reports)
+  {
+    out += report;
+  }
+
+  auto output = std::size(paths) == 3 ? std::fopen(paths[2], "wb") : stdout;
+  if (output == nullptr || std::fwrite(out.data(), 1, std::size(out), output) != std::size(out))
+  {
+    std::fprintf(stderr, "fugue-diff: could not write diff\n");
+    return 1;
+  }
+
+  if (output != stdout)
+  {
+    std::fclose(output);
+  }
+
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::fprintf(
+      stderr,
+      "fugue-diff: %zu removed, %zu added, %zu modified of %zu matched functions in %.2fs\n",
+      removed,
+      added,
+      static_cast<size_t>(std::count(std::begin(modified), std::end(modified), 1)),
+      std::size(matches),
+      elapsed);
+
+  return 0;
+}
@@ -0,0 +1,275 @@
+#include <vector>
+
+#include <fugue_analysis.h>
+
+#include "check.h"
+
+// Unit tests for the control-flow and call graph analyses, which depend on
+// neither IDA Pro nor FlatBuffers.
+
+namespace fugue
+{
+  namespace tests
+  {
+    const uint32_t N = NO_BLOCK;
+
+    struct Graph
+    {
+      uint32_t count;
+      uint32_t entry;
+      std::vector<std::pair<uint32_t, uint32_t>> edges;
+    };
+
+    inline Dominators analyse(std::vector<Graph> graphs, size_t threads = 1)
+    {
+      auto flow_graphs = FlowGraphs();
+      for (auto &graph : graphs)
+      {
+        flow_graphs.add_function(graph.count, graph.entry, graph.edges);
+      }
+      return dominators(flow_graphs, threads);
+    }
+
+    void diamond()
+    {
+      auto result = analyse({{4, 0, {{0, 1}, {0, 2}, {1, 3}, {2, 3}}}});
+
+      CHECK((result.idom == std::vector<uint32_t>{N, 0, 0, 0}));
+      CHECK((result.ipdom == std::vector<uint32_t>{3, 3, 3, N}));
+      CHECK((result.loop_header == std::vector<uint32_t>{N, N, N, N}));
+      CHECK((result.loop_depth == std::vector<uint16_t>{0, 0, 0, 0}));
+    }
+
+    // blocks without successors are post-dominated by the virtual exit alone
+    void virtual_exit()
+    {
+      auto result = analyse({
+          {3, 0, {{0, 1}, {0, 2}}},
+          {4, 0, {{0, 1}, {1, 2}, {1, 3}}},
+      });
+
+      CHECK((result.ipdom == std::vector<uint32_t>{N, N, N, 1, N, N, N}));
+      CHECK((result.idom == std::vector<uint32_t>{N, 0, 0, N, 0, 1, 1}));
+    }
+
+    // no block reaches an exit, so none has a post-dominator
+    void no_exit()
+    {
+      auto result = analyse({{2, 0, {{0, 1}, {1, 1}}}});
+
+      CHECK((result.idom == std::vector<uint32_t>{N, 0}));
+      CHECK((result.ipdom == std::vector<uint32_t>{N, N}));
+      CHECK((result.loop_header == std::vector<uint32_t>{N, 1}));
+      CHECK((result.loop_depth == std::vector<uint16_t>{0, 1}));
+    }
+
+    void unreachable()
+    {
+      auto result = analyse({{3, 0, {{0, 1}, {2, 1}, {2, 2}}}});
+
+      CHECK((result.idom == std::vector<uint32_t>{N, 0, N}));
+      CHECK((result.ipdom == std::vector<uint32_t>{1, N, 1}));
+      CHECK((result.loop_header == std::vector<uint32_t>{N, N, N}));
+    }
+
+    void nested_loops()
+    {
+      auto result = analyse({{6, 0, {{0, 1}, {1, 2}, {2, 3}, {3, 2}, {3, 4}, {4, 1}, {4, 5}}}});
+
+      CHECK((result.idom == std::vector<uint32_t>{N, 0, 1, 2, 3, 4}));
+      CHECK((result.ipdom == std::vector<uint32_t>{1, 2, 3, 4, 5, N}));
+      CHECK((result.loop_header == std::vector<uint32_t>{N, 1, 2, 2, 1, N}));
+      CHECK((result.loop_depth == std::vector<uint16_t>{0, 1, 2, 2, 1, 0}));
+    }
+
+    // a cycle entered at two blocks has no header dominating the other, so
+    // neither retreating edge is a back edge
+    void irreducible()
+    {
+      auto result = analyse({{4, 0, {{0, 1}, {0, 2}, {1, 2}, {2, 1}, {1, 3}}}});
+
+      CHECK((result.idom == std::vector<uint32_t>{N, 0, 0, 1}));
+      CHECK((result.ipdom == std::vector<uint32_t>{1, 3, 1, N}));
+      CHECK((result.loop_header == std::vector<uint32_t>{N, N, N, N}));
+      CHECK((result.loop_depth == std::vector<uint16_t>{0, 0, 0, 0}));
+    }
+
+    // an irreducible region within a natural loop belongs to the loop
+    void irreducible_in_loop()
+    {
+      auto result = analyse({{6, 0, {{0, 1}, {1, 2}, {1, 3}, {2, 3}, {3, 2}, {3, 4}, {4, 1}, {4, 5}}}});
+
+      CHECK((result.idom == std::vector<uint32_t>{N, 0, 1, 1, 3, 4}));
+      CHECK((result.loop_header == std::vector<uint32_t>{N, 1, 1, 1, 1, N}));
+      CHECK((result.loop_depth == std::vector<uint16_t>{0, 1, 1, 1, 1, 0}));
+    }
+
+    // dominance is tested by dominator tree intervals: a retreating edge
+    // between sibling subtrees is not a back edge, while one to an ancestor
+    // several levels up is
+    void dominance_intervals()
+    {
+      // 0 -> 1 -> 2 -> 3, 0 -> 4 -> 5, 5 -> 2 (cross), 3 -> 1 (back), 5 -> 4 (back)
+      auto result = analyse({{6, 0, {{0, 1}, {1, 2}, {2, 3}, {0, 4}, {4, 5}, {5, 2}, {3, 1}, {5, 4}}}});
+
+      CHECK((result.idom == std::vector<uint32_t>{N, 0, 0, 2, 0, 4}));
+      CHECK((result.loop_header == std::vector<uint32_t>{N, N, N, N, 4, 4}));
+
+      // a long chain with a back edge from its last block to its first
+      auto count = uint32_t(10000);
+      auto chain = Graph{count + 1, 0, {}};
+      for (uint32_t block = 0; block != count; ++block)
+      {
+        chain.edges.emplace_back(block, block + 1);
+      }
+      chain.edges.emplace_back(count - 1, 1);
+
+      result = analyse({chain});
+
+      CHECK(result.idom[count] == count - 1);
+      CHECK(result.loop_header[0] == N);
+      CHECK(result.loop_header[count / 2] == 1);
+      CHECK(result.loop_header[count] == N);
+      CHECK(result.loop_depth[count - 1] == 1);
+    }
+
+    // results are stored at each function's offset, whatever the entry and
+    // the number of workers
+    void functions()
+    {
+      auto graphs = std::vector<Graph>{
+          {3, 2, {{2, 0}, {0, 1}, {1, 0}}},
+          {0, 0, {}},
+          {1, 0, {}},
+          {4, 0, {{0, 1}, {0, 2}, {1, 3}, {2, 3}}},
+      };
+
+      auto result = analyse(graphs, 4);
+
+      CHECK((result.idom == std::vector<uint32_t>{2, 0, N, N, N, 0, 0, 0}));
+      CHECK((result.ipdom == std::vector<uint32_t>{N, N, N, N, 3, 3, 3, N}));
+      CHECK((result.loop_header == std::vector<uint32_t>{0, 0, N, N, N, N, N, N}));
+    }
+
+    // checks the invariants of a set of components: each calls only itself
+    // and components of lower levels, and levels and members are listed in
+    // order
+    void check_sccs(CallGraphSccs const &result, size_t functions, std::vector<std::pair<uint32_t, uint32_t>> const &edges)
+    {
+      auto components = std::size(result.scc_level);
+
+      CHECK(std::size(result.function_scc) == functions);
+      CHECK(std::size(result.scc_functions) == functions);
+      CHECK(result.level_offsets.back() == components);
+
+      for (auto [caller, callee] : edges)
+      {
+        if (caller >= functions || callee >= functions)
+        {
+          continue;
+        }
+
+        auto from = result.function_scc[caller];
+        auto to = result.function_scc[callee];
+        CHECK(from == to || result.scc_level[from] > result.scc_level[to]);
+      }
+
+      for (size_t level = 0; level + 1 < std::size(result.level_offsets); ++level)
+      {
+        for (auto scc = result.level_offsets[level]; scc != result.level_offsets[level + 1]; ++scc)
+        {
+          CHECK(result.scc_level[scc] == level);
+        }
+      }
+
+      for (size_t scc = 0; scc != components; ++scc)
+      {
+        auto end = scc + 1 == components ? functions : result.scc_function_offsets[scc + 1];
+        for (auto member = result.scc_function_offsets[scc]; member != end; ++member)
+        {
+          CHECK(result.function_scc[result.scc_functions[member]] == scc);
+          CHECK(member == result.scc_function_offsets[scc] || result.scc_functions[member - 1] < result.scc_functions[member]);
+        }
+      }
+    }
+
+    void sccs()
+    {
+      // {0, 1} cycle calling 2; 3 disconnected; 4 self-recursive; 5 calls 3;
+      // 6 calls {0, 1}; edges to functions that are not exported are dropped
+      auto edges = std::vector<std::pair<uint32_t, uint32_t>>{
+          {0, 1}, {1, 0}, {1, 2}, {4, 4}, {5, 3}, {6, 0}, {6, 0}, {2, 9}, {9, 2}};
+      auto input = edges;
+
+      auto result = call_graph_sccs(7, edges);
+      check_sccs(result, 7, input);
+
+      CHECK(std::size(result.scc_level) == 6);
+      CHECK((result.level_offsets == std::vector<uint32_t>{0, 3, 5, 6}));
+      CHECK(result.function_scc[0] == result.function_scc[1]);
+
+      auto level = [&](uint32_t function) {
+        return result.scc_level[result.function_scc[function]];
+      };
+
+      CHECK(level(2) == 0);
+      CHECK(level(3) == 0);
+      CHECK(level(4) == 0);
+      CHECK(level(0) == 1);
+      CHECK(level(5) == 1);
+      CHECK(level(6) == 2);
+
+      auto cycle = result.function_scc[0];
+      CHECK(result.scc_functions[result.scc_function_offsets[cycle]] == 0);
+      CHECK(result.scc_functions[result.scc_function_offsets[cycle] + 1] == 1);
+    }
+
+    void scc_chain()
+    {
+      auto count = uint32_t(5000);
+      auto edges = std::vector<std::pair<uint32_t, uint32_t>>();
+      for (uint32_t function = 0; function + 1 < count; ++function)
+      {
+        edges.emplace_back(function, function + 1);
+      }
+      auto input = edges;
+
+      auto result = call_graph_sccs(count, edges);
+      check_sccs(result, count, input);
+
+      CHECK(std::size(result.level_offsets) == count + 1);
+      CHECK(result.scc_level[result.function_scc[0]] == count - 1);
+      CHECK(result.function_scc[count - 1] == 0);
+    }
+
+    void scc_empty()
+    {
+      auto edges = std::vector<std::pair<uint32_t, uint32_t>>();
+      auto result = call_graph_sccs(0, edges);
+
+      CHECK(result.function_scc.empty());
+      CHECK((result.level_offsets == std::vector<uint32_t>{0}));
+    }
+
+  }; // namespace tests
+};   // namespace fugue
+
+int main()
+{
+  using namespace fugue::tests;
+
+  diamond();
+  virtual_exit();
+  no_exit();
+  unreachable();
+  nested_loops();
+  irreducible();
+  irreducible_in_loop();
+  dominance_intervals();
+  functions();
+  sccs();
+  scc_chain();
+  scc_empty();
+
+  return report();
+}
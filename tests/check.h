@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdio>
+
+namespace fugue
+{
+  namespace tests
+  {
+    inline int failures = 0;
+
+    // reports the number of failed checks; the exit code of a test
+    inline int report()
+    {
+      if (failures != 0)
+      {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+      }
+      return 0;
+    }
+
+  }; // namespace tests
+};   // namespace fugue
+
+#define CHECK(condition)                                                                  \
+  do                                                                                      \
+  {                                                                                       \
+    if (!(condition))                                                                     \
+    {                                                                                     \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      ++fugue::tests::failures;                                                           \
+    }                                                                                     \
+  } while (false)
@@ -0,0 +1,367 @@
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <fcntl.h>
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+// NOTE: the builder reports through IDA's `msg` within the plugin
+inline void msg(const char *format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  std::vfprintf(stderr, format, args);
+  va_end(args);
+}
+
+#include <fugue_reader.h>
+#include <fugue_sink.h>
+
+#include "check.h"
+
+// Round-trip tests of the FDB reader over exports written by ProjectBuilder;
+// they need FlatBuffers and the generated schema, but not IDA Pro.
+
+namespace fugue
+{
+  namespace tests
+  {
+    struct Architecture
+    {
+      std::string processor;
+      std::string variant;
+      uint32_t bits;
+      bool is_be;
+
+      friend bool operator<(const Architecture &l, const Architecture &r)
+      {
+        return l.processor < r.processor || (l.processor == r.processor && l.variant < r.variant);
+      }
+    };
+
+    using Builder = ProjectBuilder<Architecture>;
+
+    struct TestBlock
+    {
+      uint64_t address;
+      uint64_t size;
+      std::vector<uint32_t> succs;
+    };
+
+    struct TestFunction
+    {
+      std::string symbol;
+      std::vector<TestBlock> blocks;
+    };
+
+    inline std::string temp_path(const char *name)
+    {
+      return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    // exports `functions`, each entered at its first block; `extra` may add
+    // to the project before it is written
+    template <typename F>
+    inline bool write_project(const std::string &path, std::vector<TestFunction> const &functions, F extra)
+    {
+      auto builder = Builder();
+      auto arch = builder.architecture(Architecture{"x86", "x86-64", 64, false});
+
+      builder.reserve_segments(0);
+      builder.reserve_functions(std::size(functions));
+
+      for (uint32_t f = 0; f != std::size(functions); ++f)
+      {
+        auto fid = Id<Function>(f);
+        auto const &blocks = functions[f].blocks;
+
+        auto preds = std::vector<std::vector<uint32_t>>(std::size(blocks));
+        for (uint32_t b = 0; b != std::size(blocks); ++b)
+        {
+          for (auto succ : blocks[b].succs)
+          {
+            preds[succ].push_back(b);
+          }
+        }
+
+        builder.reserve_function_refs(0);
+        builder.reserve_function_blocks(std::size(blocks));
+
+        for (uint32_t b = 0; b != std::size(blocks); ++b)
+        {
+          auto bid = Id<BasicBlock>(fid, b);
+
+          builder.reserve_block_preds(std::size(preds[b]));
+          builder.reserve_block_succs(std::size(blocks[b].succs));
+
+          for (size_t i = 0; i != std::size(preds[b]); ++i)
+          {
+            builder.set_block_pred(fid, bid, i, Id<BasicBlock>(fid, preds[b][i]));
+          }
+
+          for (size_t i = 0; i != std::size(blocks[b].succs); ++i)
+          {
+            builder.set_block_succ(fid, bid, i, Id<BasicBlock>(fid, blocks[b].succs[i]));
+          }
+
+          builder.set_block(bid, blocks[b].address, blocks[b].size, arch);
+        }
+
+        builder.set_function(fid, functions[f].symbol, blocks.front().address, Id<BasicBlock>(fid, 0));
+      }
+
+      extra(builder);
+
+      return builder.write_to_file(path);
+    }
+
+    inline bool write_project(const std::string &path, std::vector<TestFunction> const &functions)
+    {
+      return write_project(path, functions, [](Builder &) {});
+    }
+
+    inline std::vector<uint8_t> read_file(const std::string &path)
+    {
+      auto file = std::ifstream(path, std::ios::binary);
+      return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {});
+    }
+
+    inline bool write_file(const std::string &path, std::vector<uint8_t> const &bytes)
+    {
+      auto file = std::ofstream(path, std::ios::binary | std::ios::trunc);
+      file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(std::size(bytes)));
+      return static_cast<bool>(file);
+    }
+
+    // `outer` spans the blocks of `inner`, and the blocks of `pair` overlap
+    inline std::vector<TestFunction> overlapping_functions()
+    {
+      return {
+          {"outer", {{0x1000, 0x100, {}}}},
+          {"inner", {{0x1010, 0x10, {1}}, {0x1030, 0x10, {}}}},
+          {"pair", {{0x2000, 0x10, {1}}, {0x2008, 0x18, {}}}},
+      };
+    }
+
+    inline bool at(FdbReader const &reader, uint64_t address, uint32_t function, uint32_t block)
+    {
+      auto ref = reader.block_at(address);
+      return ref.has_value() && ref->function == function && ref->block == block;
+    }
+
+    void block_lookup()
+    {
+      auto path = temp_path("fugue-reader-blocks.fdb");
+      CHECK(write_project(path, overlapping_functions()));
+
+      auto reader = FdbReader();
+      CHECK(reader.open(path.c_str()));
+
+      CHECK(!reader.block_at(0x0fff).has_value());
+      CHECK(at(reader, 0x1000, 0, 0));
+      CHECK(at(reader, 0x1015, 1, 0));
+      CHECK(at(reader, 0x1035, 1, 1));
+
+      // within `outer` alone, past (and between) the blocks nested within it
+      CHECK(at(reader, 0x1025, 0, 0));
+      CHECK(at(reader, 0x1050, 0, 0));
+      CHECK(at(reader, 0x10ff, 0, 0));
+      CHECK(!reader.block_at(0x1100).has_value());
+      CHECK(!reader.block_at(0x1800).has_value());
+
+      // the block starting nearest below an address is preferred
+      CHECK(at(reader, 0x2004, 2, 0));
+      CHECK(at(reader, 0x200c, 2, 1));
+      CHECK(at(reader, 0x2018, 2, 1));
+      CHECK(!reader.block_at(0x2020).has_value());
+
+      CHECK(reader.function_at(0x1050) == std::optional<uint32_t>(0));
+      CHECK(reader.function_at(0x1035) == std::optional<uint32_t>(1));
+
+      auto ec = std::error_code();
+      std::filesystem::remove(path, ec);
+    }
+
+    // a function table that fails verification is rejected on access alone;
+    // the project opens and the other functions remain readable
+    void corrupt_function()
+    {
+      auto path = temp_path("fugue-reader-corrupt.fdb");
+      CHECK(write_project(path, overlapping_functions()));
+
+      auto bytes = read_file(path);
+      auto table = reinterpret_cast<const uint8_t *>(schema::GetProject(bytes.data())->functions()->Get(1));
+      auto offset = static_cast<size_t>(table - bytes.data());
+
+      // point the table's vtable far beyond the end of the buffer
+      auto vtable = std::numeric_limits<flatbuffers::soffset_t>::min() / 2;
+      flatbuffers::WriteScalar(bytes.data() + offset, vtable);
+      CHECK(write_file(path, bytes));
+
+      auto reader = FdbReader();
+      CHECK(reader.open(path.c_str()));
+      CHECK(reader.function_count() == 3);
+
+      CHECK(reader.function(0) != nullptr);
+      CHECK(reader.function(1) == nullptr);
+      CHECK(reader.function(2) != nullptr);
+
+      // the block index still resolves its blocks, but not their contents
+      CHECK(at(reader, 0x1015, 1, 0));
+      CHECK(reader.block(BlockRef{1, 0}) == nullptr);
+      CHECK(reader.block(BlockRef{2, 1}) != nullptr);
+
+      CHECK(reader.function_by_name("outer") == std::optional<uint32_t>(0));
+      CHECK(!reader.function_by_name("inner").has_value());
+
+      CHECK(!reader.verify_all());
+
+      auto fresh = FdbReader();
+      CHECK(fresh.open(path.c_str()));
+      CHECK(!fresh.verify_all());
+      CHECK(fresh.function(1) == nullptr);
+
+      auto ec = std::error_code();
+      std::filesystem::remove(path, ec);
+    }
+
+    // after a full verification, accessors no longer verify, and return the
+    // same entities
+    void verify_then_access()
+    {
+      auto path = temp_path("fugue-reader-verified.fdb");
+      CHECK(write_project(path, overlapping_functions()));
+
+      auto reader = FdbReader();
+      CHECK(reader.open(path.c_str()));
+      CHECK(reader.verify_all());
+
+      for (uint32_t f = 0; f != reader.function_count(); ++f)
+      {
+        CHECK(reader.function(f) != nullptr);
+      }
+      CHECK(reader.function(3) == nullptr);
+
+      CHECK(reader.function_by_name("pair") == std::optional<uint32_t>(2));
+      CHECK(reader.function(2)->address() == 0x2000);
+
+      auto block = reader.block(BlockRef{1, 0});
+      CHECK(block != nullptr && block->address() == 0x1010);
+
+      auto succs = reader.successors(block);
+      CHECK(succs.size() == 1);
+      for (auto succ : succs)
+      {
+        CHECK(succ.function == 1 && succ.block == 1);
+      }
+
+      auto preds = reader.predecessors(reader.block(BlockRef{1, 1}));
+      CHECK(preds.size() == 1);
+      for (auto pred : preds)
+      {
+        CHECK(pred.function == 1 && pred.block == 0);
+      }
+
+      CHECK(at(reader, 0x200c, 2, 1));
+
+      auto ec = std::error_code();
+      std::filesystem::remove(path, ec);
+    }
+
+    using ConstantTuple = std::tuple<uint64_t, uint64_t, uint32_t, uint32_t, uint8_t>;
+
+    // values and address deltas straddle each varint width, addresses fall
+    // as values rise, and one value spans several delta chunks
+    void constants(bool deltas)
+    {
+      auto path = temp_path(deltas ? "fugue-reader-deltas.fdb" : "fugue-reader-constants.fdb");
+
+      auto values = std::vector<uint64_t>{
+          0, 1, 0x7f, 0x80, 0x3fff, 0x4000, 0x1fffff, 0x200000,
+          0xffffffff, 0x100000000, std::numeric_limits<uint64_t>::max() - 1, std::numeric_limits<uint64_t>::max()};
+      auto steps = std::vector<uint64_t>{0x3f, 0x40, 0x1fff, 0x2000, 1};
+
+      auto expected = std::vector<ConstantTuple>();
+      for (size_t v = 0; v != std::size(values); ++v)
+      {
+        auto count = v == 3 ? 3 * CONSTANT_CHUNK + 5 : v + 1;
+        auto address = uint64_t(0x40000000) - 0x100000 * v;
+        if (v == std::size(values) - 1)
+        {
+          address = std::numeric_limits<uint64_t>::max() - 0x10000;
+        }
+
+        for (size_t i = 0; i != count; ++i)
+        {
+          auto function = static_cast<uint32_t>(i % 3);
+          auto block = static_cast<uint32_t>(function != 0 ? i % 2 : 0);
+          auto kind = static_cast<uint8_t>(i % 2 != 0 ? CONSTANT_DISPLACEMENT : CONSTANT_IMMEDIATE);
+          expected.emplace_back(values[v], address, function, block, kind);
+          address += steps[i % std::size(steps)];
+        }
+      }
+
+      CHECK(write_project(path, overlapping_functions(), [&](Builder &builder) {
+        builder.set_constant_deltas(deltas);
+
+        // added out of order, as the exporter does
+        for (auto entry = std::rbegin(expected); entry != std::rend(expected); ++entry)
+        {
+          auto [value, address, function, block, kind] = *entry;
+          builder.add_constant(value, address, Id<BasicBlock>(Id<Function>(function), block), static_cast<ConstantKind>(kind));
+        }
+      }));
+
+      auto reader = FdbReader();
+      CHECK(reader.open(path.c_str()));
+
+      for (auto value : values)
+      {
+        auto found = std::vector<ConstantTuple>();
+        auto count = reader.for_each_constant(value, [&](Constant const &constant) {
+          found.emplace_back(constant.value, constant.address, constant.block.function, constant.block.block, constant.kind);
+        });
+
+        auto wanted = std::vector<ConstantTuple>();
+        std::copy_if(std::begin(expected), std::end(expected), std::back_inserter(wanted), [&](ConstantTuple const &entry) {
+          return std::get<0>(entry) == value;
+        });
+
+        CHECK(count == std::size(found));
+        CHECK(found == wanted);
+      }
+
+      for (auto value : {uint64_t(2), uint64_t(0x81), uint64_t(0x4001), uint64_t(0x100000001)})
+      {
+        CHECK(reader.for_each_constant(value, [](Constant const &) {}) == 0);
+      }
+
+      auto ec = std::error_code();
+      std::filesystem::remove(path, ec);
+    }
+
+  }; // namespace tests
+};   // namespace fugue
+
+int main()
+{
+  using namespace fugue::tests;
+
+  block_lookup();
+  corrupt_function();
+  verify_then_access();
+  constants(false);
+  constants(true);
+
+  return report();
+}